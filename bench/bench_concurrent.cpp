@@ -0,0 +1,108 @@
+/*
+ * File:   bench_concurrent.cpp
+ *
+ * Appends N items to one shared list from 1..32 threads and prints the time
+ * and throughput of each strategy:
+ *      coarse      XArrayList behind one std::mutex, locked per item
+ *      array-add   ConcurrentArrayList::add (exclusive lock per item)
+ *      appender    ConcurrentArrayList::Appender (one lock per batch)
+ *      linked-add  ConcurrentLinkedList::add (locks only the tail node)
+ * and a read test: every thread reads random items with valueAt (shared lock).
+ *
+ * Build: g++ -std=c++17 -O2 -pthread -Iinclude bench/bench_concurrent.cpp
+ * Usage: bench_concurrent [N=4000000] [maxThreads=32]
+ */
+
+#include "list/XArrayList.h"
+#include "list/ConcurrentArrayList.h"
+#include "list/ConcurrentLinkedList.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+template <class Work>
+double timeThreads(int threads, Work work)
+{
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (int id = 0; id < threads; id++)
+        workers.emplace_back(work, id);
+    for (thread &worker : workers)
+        worker.join();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void report(const char *name, int threads, int n, double ms, int size)
+{
+    printf("%-11s threads=%2d  %9.1f ms  %8.2f Mitems/s  (size %d)\n",
+           name, threads, ms, n / ms / 1000.0, size);
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 4000000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 32;
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        int perThread = n / threads;
+
+        {
+            XArrayList<int> list;
+            std::mutex lock;
+            double ms = timeThreads(threads, [&](int id)
+                                    {
+                                        for (int i = 0; i < perThread; i++)
+                                        {
+                                            std::lock_guard<std::mutex> guard(lock);
+                                            list.add(id * perThread + i);
+                                        } });
+            report("coarse", threads, perThread * threads, ms, list.size());
+        }
+        {
+            ConcurrentArrayList<int> list;
+            double ms = timeThreads(threads, [&](int id)
+                                    {
+                                        for (int i = 0; i < perThread; i++)
+                                            list.add(id * perThread + i); });
+            report("array-add", threads, perThread * threads, ms, list.size());
+        }
+        {
+            ConcurrentArrayList<int> list;
+            double ms = timeThreads(threads, [&](int id)
+                                    {
+                                        ConcurrentArrayList<int>::Appender appender(&list);
+                                        for (int i = 0; i < perThread; i++)
+                                            appender.add(id * perThread + i); });
+            report("appender", threads, perThread * threads, ms, list.size());
+
+            long checksum = 0;
+            ms = timeThreads(threads, [&](int id)
+                             {
+                                 unsigned state = id * 2654435761u + 1;
+                                 long sum = 0;
+                                 for (int i = 0; i < perThread; i++)
+                                 {
+                                     state = state * 1664525u + 1013904223u;
+                                     sum += list.valueAt(state % list.size());
+                                 }
+                                 if (sum == 42)
+                                     checksum++; });
+            report("array-read", threads, perThread * threads, ms, list.size() + (int)checksum);
+        }
+        {
+            ConcurrentLinkedList<int> list;
+            double ms = timeThreads(threads, [&](int id)
+                                    {
+                                        for (int i = 0; i < perThread; i++)
+                                            list.add(id * perThread + i); });
+            report("linked-add", threads, perThread * threads, ms, list.size());
+        }
+        printf("\n");
+    }
+    return 0;
+}
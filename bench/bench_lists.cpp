@@ -0,0 +1,402 @@
+/*
+ * File:   bench_lists.cpp
+ *
+ * Microbenchmarks of the list library against the std containers:
+ *      containers  XArrayList, DLinkedList, std::vector, std::list, std::deque
+ *      items       int, double, Point, Point*
+ *      sizes       100, 1000, ... up to maxSize
+ *      operations
+ *          append      build a list of "size" items with add/push_back        (ns per item)
+ *          insert      insert in the middle of a list of "size" items         (ns per insert)
+ *          remove      remove from the middle of a list of "size" items       (ns per remove)
+ *          get         read the item at a random location                     (ns per read)
+ *          indexOf     find an item 3/4 down the list                         (ns per search)
+ *          iterate     visit every item with the list's iterator              (ns per item)
+ *          copy        copy-construct the list                                (ns per item)
+ *          copy_write  copy-construct, then write the first item              (ns per item)
+ *          clear       remove all items                                       (ns per item)
+ *
+ * Each case is repeated (in growing batches, as Google Benchmark does) until
+ * it has run for minTimeMs. Results go to stdout as JSON, one record per case,
+ * so runs can be compared for regressions; progress goes to stderr.
+ *
+ * "copy" of an XArrayList only shares its buffer (copy-on-write);
+ * "copy_write" includes the deep copy the first write makes.
+ *
+ * Build: g++ -std=c++17 -O2 -DNDEBUG -pthread -Iinclude bench/bench_lists.cpp -o bench_lists
+ * Usage: bench_lists [maxSize=1000000] [minTimeMs=50] [filter]
+ *      maxSize 100000000 runs the full 1e2..1e8 sweep (needs tens of GB for std::list<Point*>);
+ *      filter keeps only the cases whose "container/type/op" contains it, e.g. "XArrayList/int"
+ */
+
+#include "list/XArrayList.h"
+#include "list/DLinkedList.h"
+#include "util/Point.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <string>
+#include <vector>
+using namespace std;
+
+static double minTimeMs = 50;
+
+// keep(value): make the compiler believe "value" is used, so the work producing it is not removed
+template <class V>
+inline void keep(V const &value)
+{
+    asm volatile(""
+                 :
+                 : "r,m"(value)
+                 : "memory");
+}
+
+static double nowMs()
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//////////////////////////////////////////////////////////////////////
+// Items
+//////////////////////////////////////////////////////////////////////
+
+// Items<T>: the items stored in the lists, item(i) for i = 0, 1, ...
+template <class T>
+struct Items;
+
+template <>
+struct Items<int>
+{
+    static const char *name() { return "int"; }
+    Items(int /*n*/) {}
+    int item(int i) { return i; }
+    static double weight(int item) { return item; }
+};
+
+template <>
+struct Items<double>
+{
+    static const char *name() { return "double"; }
+    Items(int /*n*/) {}
+    double item(int i) { return i * 0.5; }
+    static double weight(double item) { return item; }
+};
+
+template <>
+struct Items<Point>
+{
+    static const char *name() { return "Point"; }
+    Items(int /*n*/) {}
+    Point item(int i) { return Point(i, i + 1, i + 2); }
+    static double weight(const Point &item) { return item.getX(); }
+};
+
+template <>
+struct Items<Point *>
+{
+    vector<Point> pool; // the lists only hold pointers into this pool
+    static const char *name() { return "Point*"; }
+    Items(int n) : pool(n > 0 ? n : 1)
+    {
+        for (int i = 0; i < (int)pool.size(); i++)
+            pool[i] = Point(i, i + 1, i + 2);
+    }
+    Point *item(int i) { return &pool[i % pool.size()]; }
+    static double weight(const Point *item) { return item->getX(); }
+};
+
+//////////////////////////////////////////////////////////////////////
+// Containers: the same operations on the library lists and the std containers
+//////////////////////////////////////////////////////////////////////
+
+template <class C>
+struct Name;
+template <class T>
+struct Name<XArrayList<T>>
+{
+    static const char *get() { return "XArrayList"; }
+};
+template <class T>
+struct Name<DLinkedList<T>>
+{
+    static const char *get() { return "DLinkedList"; }
+};
+template <class T>
+struct Name<vector<T>>
+{
+    static const char *get() { return "std::vector"; }
+};
+template <class T>
+struct Name<list<T>>
+{
+    static const char *get() { return "std::list"; }
+};
+template <class T>
+struct Name<deque<T>>
+{
+    static const char *get() { return "std::deque"; }
+};
+
+template <class T>
+void append(XArrayList<T> &c, const T &item) { c.add(item); }
+template <class T>
+void append(DLinkedList<T> &c, const T &item) { c.add(item); }
+template <class C>
+void append(C &c, const typename C::value_type &item) { c.push_back(item); }
+
+template <class T>
+void insertAt(XArrayList<T> &c, int index, const T &item) { c.add(index, item); }
+template <class T>
+void insertAt(DLinkedList<T> &c, int index, const T &item) { c.add(index, item); }
+template <class C>
+void insertAt(C &c, int index, const typename C::value_type &item) { c.insert(next(c.begin(), index), item); }
+
+template <class T>
+void removeAt(XArrayList<T> &c, int index) { c.removeAt(index); }
+template <class T>
+void removeAt(DLinkedList<T> &c, int index) { c.removeAt(index); }
+template <class C>
+void removeAt(C &c, int index) { c.erase(next(c.begin(), index)); }
+
+template <class T>
+T &at(XArrayList<T> &c, int index) { return c.get(index); }
+template <class T>
+T &at(DLinkedList<T> &c, int index) { return c.get(index); }
+template <class C>
+typename C::value_type &at(C &c, int index) { return *next(c.begin(), index); }
+
+template <class T>
+int find(XArrayList<T> &c, const T &item) { return c.indexOf(item); }
+template <class T>
+int find(DLinkedList<T> &c, const T &item) { return c.indexOf(item); }
+template <class C>
+int find(C &c, typename C::value_type item)
+{
+    int index = 0;
+    for (auto it = c.begin(); it != c.end(); ++it, ++index)
+        if (*it == item)
+            return index;
+    return -1;
+}
+
+template <class C>
+int sizeOf(C &c) { return (int)c.size(); }
+
+template <class C, class T>
+void fill(C &c, Items<T> &items, int n)
+{
+    for (int i = 0; i < n; i++)
+        append(c, items.item(i));
+}
+
+//////////////////////////////////////////////////////////////////////
+// Timing
+//////////////////////////////////////////////////////////////////////
+
+struct Result
+{
+    double nsPerOp;
+    long ops;
+};
+
+// timeBatches(maxOps, body): body(ops) runs "ops" operations; batches grow 1, 2, 4, ...
+//      until minTimeMs has passed (or maxOps were run)
+template <class Body>
+Result timeBatches(long maxOps, Body body)
+{
+    long done = 0, batch = 1;
+    double elapsed = 0;
+    while (elapsed < minTimeMs && done < maxOps)
+    {
+        if (batch > maxOps - done)
+            batch = maxOps - done;
+        double start = nowMs();
+        body(batch);
+        elapsed += nowMs() - start;
+        done += batch;
+        batch *= 2;
+    }
+    return Result{elapsed * 1e6 / done, done};
+}
+
+// timeRepeats(items, prepare, body): repeat prepare() (untimed) + body() (timed) until minTimeMs
+//      has passed; body handles "items" items each time
+template <class Prepare, class Body>
+Result timeRepeats(int items, Prepare prepare, Body body)
+{
+    long repeats = 0;
+    double elapsed = 0;
+    while (elapsed < minTimeMs || repeats == 0)
+    {
+        prepare();
+        double start = nowMs();
+        body();
+        elapsed += nowMs() - start;
+        repeats++;
+    }
+    return Result{elapsed * 1e6 / (repeats * (double)(items > 0 ? items : 1)), repeats * (long)items};
+}
+
+//////////////////////////////////////////////////////////////////////
+// Cases
+//////////////////////////////////////////////////////////////////////
+
+static const char *filter = 0;
+static bool firstRecord = true;
+
+void report(const char *container, const char *type, const char *op, int size, Result result)
+{
+    printf("%s\n    {\"container\": \"%s\", \"type\": \"%s\", \"op\": \"%s\", \"size\": %d, \"ns_per_op\": %.3f, \"ops\": %ld}",
+           firstRecord ? "" : ",", container, type, op, size, result.nsPerOp, result.ops);
+    firstRecord = false;
+    fflush(stdout);
+    fprintf(stderr, "%-12s %-7s %-11s %10d  %12.3f ns/op\n", container, type, op, size, result.nsPerOp);
+}
+
+bool selected(const char *container, const char *type, const char *op)
+{
+    if (filter == 0)
+        return true;
+    string name = string(container) + "/" + type + "/" + op;
+    return name.find(filter) != string::npos;
+}
+
+template <class C, class T>
+void benchCases(int n)
+{
+    const char *container = Name<C>::get();
+    const char *type = Items<T>::name();
+    Items<T> items(n);
+
+    if (selected(container, type, "append"))
+    {
+        C *c = 0;
+        report(container, type, "append", n, timeRepeats(n, [&]
+                                                         { delete c; c = new C(); },
+                                                         [&]
+                                                         {
+                                                             fill(*c, items, n);
+                                                             keep(sizeOf(*c));
+                                                         }));
+        delete c;
+    }
+    if (selected(container, type, "insert"))
+    {
+        C c;
+        fill(c, items, n);
+        report(container, type, "insert", n, timeBatches(n, [&](long ops)
+                                                         {
+                                                             for (long i = 0; i < ops; i++)
+                                                                 insertAt(c, sizeOf(c) / 2, items.item((int)i));
+                                                         }));
+    }
+    if (selected(container, type, "remove"))
+    {
+        C c;
+        fill(c, items, n);
+        report(container, type, "remove", n, timeBatches(n / 2, [&](long ops)
+                                                         {
+                                                             for (long i = 0; i < ops; i++)
+                                                                 removeAt(c, sizeOf(c) / 2);
+                                                         }));
+    }
+
+    C c;
+    fill(c, items, n);
+    if (selected(container, type, "get"))
+    {
+        unsigned state = 12345;
+        report(container, type, "get", n, timeBatches(1L << 26, [&](long ops)
+                                                      {
+                                                          double sum = 0;
+                                                          for (long i = 0; i < ops; i++)
+                                                          {
+                                                              state = state * 1664525u + 1013904223u;
+                                                              sum += Items<T>::weight(at(c, (int)(state % (unsigned)n)));
+                                                          }
+                                                          keep(sum);
+                                                      }));
+    }
+    if (selected(container, type, "indexOf"))
+    {
+        T target = items.item(n - n / 4 - 1);
+        report(container, type, "indexOf", n, timeBatches(1L << 26, [&](long ops)
+                                                          {
+                                                              for (long i = 0; i < ops; i++)
+                                                                  keep(find(c, target));
+                                                          }));
+    }
+    if (selected(container, type, "iterate"))
+    {
+        report(container, type, "iterate", n, timeRepeats(n, [] {}, [&]
+                                                          {
+                                                              double sum = 0;
+                                                              for (auto it = c.begin(); it != c.end(); ++it)
+                                                                  sum += Items<T>::weight(*it);
+                                                              keep(sum);
+                                                          }));
+    }
+    if (selected(container, type, "copy"))
+    {
+        report(container, type, "copy", n, timeRepeats(n, [] {}, [&]
+                                                       {
+                                                           C copy(c);
+                                                           keep(sizeOf(copy));
+                                                       }));
+    }
+    if (selected(container, type, "copy_write"))
+    {
+        report(container, type, "copy_write", n, timeRepeats(n, [] {}, [&]
+                                                             {
+                                                                 C copy(c);
+                                                                 auto it = copy.begin();
+                                                                 *it = items.item(1);
+                                                                 keep(sizeOf(copy));
+                                                             }));
+    }
+    if (selected(container, type, "clear"))
+    {
+        C cleared;
+        report(container, type, "clear", n, timeRepeats(n, [&]
+                                                        { fill(cleared, items, n); },
+                                                        [&]
+                                                        {
+                                                            cleared.clear();
+                                                            keep(sizeOf(cleared));
+                                                        }));
+    }
+}
+
+template <class T>
+void benchType(int n)
+{
+    benchCases<XArrayList<T>, T>(n);
+    benchCases<DLinkedList<T>, T>(n);
+    benchCases<vector<T>, T>(n);
+    benchCases<list<T>, T>(n);
+    benchCases<deque<T>, T>(n);
+}
+
+int main(int argc, char **argv)
+{
+    long maxSize = argc > 1 ? atol(argv[1]) : 1000000;
+    minTimeMs = argc > 2 ? atof(argv[2]) : 50;
+    filter = argc > 3 ? argv[3] : 0;
+
+    printf("{\n  \"context\": {\"max_size\": %ld, \"min_time_ms\": %g, \"compiler\": \"%s\"},\n  \"benchmarks\": [",
+           maxSize, minTimeMs, __VERSION__);
+    for (long n = 100; n <= maxSize; n *= 10)
+    {
+        benchType<int>((int)n);
+        benchType<double>((int)n);
+        benchType<Point>((int)n);
+        benchType<Point *>((int)n);
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
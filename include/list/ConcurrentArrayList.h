@@ -0,0 +1,310 @@
+/*
+ * File:   ConcurrentArrayList.h
+ *
+ * ConcurrentArrayList<T>: an XArrayList that can be shared by threads.
+ * Every operation takes a reader-writer lock: queries (get, indexOf, size,
+ * toString, ...) run concurrently, changes run one at a time.
+ *
+ * Threads that mostly append should use an Appender: it collects items in a
+ * buffer owned by its thread and merges them into the list in bulk (one
+ * exclusive lock per batch instead of one per item). Items of one Appender
+ * keep their order; batches of different Appenders interleave.
+ *
+ * NOTE: get(index) returns a reference into the list; it stays valid only
+ * while no other thread changes the list. Use valueAt(index) for a copy.
+ */
+
+#ifndef CONCURRENTARRAYLIST_H
+#define CONCURRENTARRAYLIST_H
+#include "list/IList.h"
+#include "list/XArrayList.h"
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+using namespace std;
+
+template <class T>
+class ConcurrentArrayList : public IList<T>
+{
+public:
+    class Appender; // forward declaration
+
+protected:
+    XArrayList<T> list;
+    mutable std::shared_mutex lock; // shared: queries; exclusive: changes
+    void (*deleteUserData)(ConcurrentArrayList<T> *); // function pointer: be called to remove items (if they are pointer type)
+
+public:
+    ConcurrentArrayList(
+        void (*deleteUserData)(ConcurrentArrayList<T> *) = 0,
+        bool (*itemEqual)(T &, T &) = 0,
+        int capacity = 10);
+    ConcurrentArrayList(const ConcurrentArrayList<T> &list) = delete;
+    ConcurrentArrayList<T> &operator=(const ConcurrentArrayList<T> &list) = delete;
+    ~ConcurrentArrayList();
+
+    // Inherit from IList: BEGIN
+    void add(T e);
+    void add(int index, T e);
+    T removeAt(int index);
+    bool removeItem(T item, void (*removeItemData)(T) = 0);
+    bool empty();
+    int size();
+    void clear();
+    T &get(int index);
+    int indexOf(T item);
+    bool contains(T item);
+    string toString(string (*item2str)(T &) = 0);
+    void forEachItem(void (*visit)(const T &, void *), void *context);
+    void addAll(const T *items, int n);
+    void addAll(IList<T> &list);
+    void insertRange(int index, const T *first, const T *last);
+    void removeRange(int from, int to);
+    void sort(bool (*comparator)(T &, T &) = 0);
+    void stableSort(bool (*comparator)(T &, T &) = 0);
+    // Inherit from IList: END
+
+    // valueAt(index): a copy of the item at location "index"
+    T valueAt(int index);
+    // forEach(fn): call fn(item) for every item, in order, under the shared lock
+    template <class Fn>
+    void forEach(Fn fn);
+
+    void println(string (*item2str)(T &) = 0)
+    {
+        cout << toString(item2str) << endl;
+    }
+
+    static void free(ConcurrentArrayList<T> *list)
+    {
+        XArrayList<T>::free(&list->list);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    // Appender: BEGIN
+    // one per thread; not thread-safe itself
+    class Appender
+    {
+    private:
+        ConcurrentArrayList<T> *pList;
+        XArrayList<T> buffer;
+        int batchSize;
+
+    public:
+        Appender(ConcurrentArrayList<T> *pList, int batchSize = 1024)
+            : pList(pList), buffer(0, 0, batchSize), batchSize(batchSize)
+        {
+        }
+        Appender(const Appender &appender) = delete;
+        Appender &operator=(const Appender &appender) = delete;
+        ~Appender()
+        {
+            flush();
+        }
+        void add(T e)
+        {
+            buffer.add(std::move(e));
+            if (buffer.size() >= batchSize)
+                flush();
+        }
+        // flush(): append the buffered items to the list now
+        void flush()
+        {
+            if (buffer.empty())
+                return;
+            {
+                std::unique_lock<std::shared_mutex> guard(pList->lock);
+                pList->list.addAll(buffer);
+            }
+            buffer.clear();
+        }
+    };
+    // Appender: END
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+ConcurrentArrayList<T>::ConcurrentArrayList(
+    void (*deleteUserData)(ConcurrentArrayList<T> *),
+    bool (*itemEqual)(T &, T &),
+    int capacity)
+    : list(0, itemEqual, capacity)
+{
+    this->deleteUserData = deleteUserData;
+}
+
+template <class T>
+ConcurrentArrayList<T>::~ConcurrentArrayList()
+{
+    if (deleteUserData)
+    {
+        deleteUserData(this);
+    }
+}
+
+template <class T>
+void ConcurrentArrayList<T>::add(T e)
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    list.add(std::move(e));
+}
+
+template <class T>
+void ConcurrentArrayList<T>::add(int index, T e)
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    list.add(index, std::move(e));
+}
+
+template <class T>
+T ConcurrentArrayList<T>::removeAt(int index)
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    return list.removeAt(index);
+}
+
+template <class T>
+bool ConcurrentArrayList<T>::removeItem(T item, void (*removeItemData)(T))
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    int index = list.indexOf(item);
+    if (index == -1)
+    {
+        return false;
+    }
+    T removed = list.removeAt(index);
+    if (removeItemData != 0)
+        removeItemData(removed);
+    return true;
+}
+
+template <class T>
+bool ConcurrentArrayList<T>::empty()
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    return list.empty();
+}
+
+template <class T>
+int ConcurrentArrayList<T>::size()
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    return list.size();
+}
+
+template <class T>
+void ConcurrentArrayList<T>::clear()
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    list.clear();
+}
+
+template <class T>
+T &ConcurrentArrayList<T>::get(int index)
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    return list.get(index);
+}
+
+template <class T>
+int ConcurrentArrayList<T>::indexOf(T item)
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    return list.indexOf(std::move(item));
+}
+
+template <class T>
+bool ConcurrentArrayList<T>::contains(T item)
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    return list.contains(std::move(item));
+}
+
+template <class T>
+string ConcurrentArrayList<T>::toString(string (*item2str)(T &))
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    return list.toString(item2str);
+}
+
+template <class T>
+void ConcurrentArrayList<T>::forEachItem(void (*visit)(const T &, void *), void *context)
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    list.forEachItem(visit, context);
+}
+
+template <class T>
+void ConcurrentArrayList<T>::addAll(const T *items, int n)
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    list.addAll(items, n);
+}
+
+template <class T>
+void ConcurrentArrayList<T>::addAll(IList<T> &list)
+{
+    // snapshot "list" before taking the exclusive lock: locking this list again would
+    // deadlock, and holding it while another concurrent list takes its own lock invites
+    // lock-order inversions (a.addAll(b) racing b.addAll(a))
+    XSortBuffer<T> items(list.size());
+    list.forEachItem([](const T &item, void *buffer)
+                     { static_cast<XSortBuffer<T> *>(buffer)->push(T(item)); },
+                     &items);
+    std::unique_lock<std::shared_mutex> guard(lock);
+    this->list.addAll(items.begin(), (int)(items.end() - items.begin()));
+}
+
+template <class T>
+void ConcurrentArrayList<T>::insertRange(int index, const T *first, const T *last)
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    list.insertRange(index, first, last);
+}
+
+template <class T>
+void ConcurrentArrayList<T>::removeRange(int from, int to)
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    list.removeRange(from, to);
+}
+
+template <class T>
+void ConcurrentArrayList<T>::sort(bool (*comparator)(T &, T &))
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    list.sort(comparator);
+}
+
+template <class T>
+void ConcurrentArrayList<T>::stableSort(bool (*comparator)(T &, T &))
+{
+    std::unique_lock<std::shared_mutex> guard(lock);
+    list.stableSort(comparator);
+}
+
+template <class T>
+T ConcurrentArrayList<T>::valueAt(int index)
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    return list.get(index);
+}
+
+template <class T>
+template <class Fn>
+void ConcurrentArrayList<T>::forEach(Fn fn)
+{
+    std::shared_lock<std::shared_mutex> guard(lock);
+    for (int index = 0; index < list.size(); index++)
+    {
+        fn(list.get(index));
+    }
+}
+
+#endif /* CONCURRENTARRAYLIST_H */
@@ -0,0 +1,724 @@
+/*
+ * File:   ConcurrentLinkedList.h
+ *
+ * ConcurrentLinkedList<T>: a singly linked list that can be shared by
+ * threads, with one mutex per node. Operations walk the list hand over hand
+ * (lock the next node, then release the previous one), so threads working
+ * on different parts of the list do not wait for each other.
+ *
+ * The list always ends with an empty "tail" node. add(e) writes the new item
+ * into that node and hangs a fresh empty node behind it: appending only locks
+ * the last node and never walks the list.
+ *
+ * Locks are always taken from head to tail, so operations cannot deadlock.
+ *
+ * The bulk operations are atomic with respect to other threads: addAll and
+ * insertRange build their nodes first and splice them in under one lock,
+ * removeRange locks its way through the range while holding the node in
+ * front of it, and sort/stableSort lock every node and relink them with a
+ * stable merge sort.
+ *
+ * NOTE: get(index) returns a reference into the list; it stays valid only
+ * while no other thread removes that item. Use valueAt(index) for a copy.
+ */
+
+#ifndef CONCURRENTLINKEDLIST_H
+#define CONCURRENTLINKEDLIST_H
+#include "list/IList.h"
+#include "list/ListPolicy.h"
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <iostream>
+#include <utility>
+using namespace std;
+
+template <class T>
+class ConcurrentLinkedList : public IList<T>
+{
+public:
+    class Node; // Forward declaration
+
+protected:
+    Node *head;             // this node does not contain user's data
+    Node *tail;             // the empty node at the end of the list, guarded by tailLock
+    std::mutex tailLock;    // taken before the tail node, only by appends
+    std::atomic<int> count; // exact when no operation is running
+    bool (*itemEqual)(T &lhs, T &rhs);                    // function pointer: test if two items (type: T&) are equal or not
+    void (*deleteUserData)(ConcurrentLinkedList<T> *); // function pointer: be called to remove items (if they are pointer type)
+
+public:
+    ConcurrentLinkedList(
+        void (*deleteUserData)(ConcurrentLinkedList<T> *) = 0,
+        bool (*itemEqual)(T &, T &) = 0);
+    ConcurrentLinkedList(const ConcurrentLinkedList<T> &list) = delete;
+    ConcurrentLinkedList<T> &operator=(const ConcurrentLinkedList<T> &list) = delete;
+    ~ConcurrentLinkedList();
+
+    // Inherit from IList: BEGIN
+    void add(T e);
+    void add(int index, T e);
+    T removeAt(int index);
+    bool removeItem(T item, void (*removeItemData)(T) = 0);
+    bool empty();
+    int size();
+    void clear();
+    T &get(int index);
+    int indexOf(T item);
+    bool contains(T item);
+    string toString(string (*item2str)(T &) = 0);
+    void forEachItem(void (*visit)(const T &, void *), void *context);
+    void addAll(const T *items, int n);
+    void addAll(IList<T> &list);
+    void insertRange(int index, const T *first, const T *last);
+    void removeRange(int from, int to);
+    void sort(bool (*comparator)(T &, T &) = 0);
+    void stableSort(bool (*comparator)(T &, T &) = 0);
+    // Inherit from IList: END
+
+    // valueAt(index): a copy of the item at location "index"
+    T valueAt(int index);
+    // forEach(fn): call fn(item) for every item, in order; each item is locked during its call
+    template <class Fn>
+    void forEach(Fn fn);
+
+    void println(string (*item2str)(T &) = 0)
+    {
+        cout << toString(item2str) << endl;
+    }
+
+    static void free(ConcurrentLinkedList<T> *list)
+    {
+        list->forEach([](T &item)
+                      { delete item; });
+    }
+
+protected:
+    static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &))
+    {
+        if (itemEqual == 0)
+            return lhs == rhs;
+        else
+            return itemEqual(lhs, rhs);
+    }
+    // lockNodeAt(index): lock and return the node at location "index" (-1: head);
+    //      throw std::out_of_range, holding no lock, if the list is shorter
+    Node *lockNodeAt(int index);
+    // lockBefore(item): lock and return the node in front of the first node holding "item";
+    //      that node is locked too. Returns 0, holding no lock, if "item" is not found
+    Node *lockBefore(T &item, int &index);
+    // newChain(first, last, chainLast): unlinked nodes holding copies of [first, last), 0 if the range is empty
+    static Node *newChain(const T *first, const T *last, Node *&chainLast);
+    // deleteChain(node, end): delete the nodes from "node" up to, not including, "end"
+    static void deleteChain(Node *node, Node *end = 0);
+    // sortBy(less): stable merge sort with any callable less(a, b), holding every lock
+    template <class Compare>
+    void sortBy(Compare less);
+    // mergeRuns: merge two sorted chains (0-terminated); on ties the node of "first" comes first
+    template <class Compare>
+    static Node *mergeRuns(Node *first, Node *second, Compare &less);
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    class Node
+    {
+    public:
+        T data;
+        Node *next; // 0 only for the tail node
+        std::mutex lock;
+        friend class ConcurrentLinkedList<T>;
+
+    public:
+        Node(Node *next = 0)
+        {
+            this->next = next;
+        }
+        Node(T data, Node *next = 0) : data(std::move(data))
+        {
+            this->next = next;
+        }
+    };
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+ConcurrentLinkedList<T>::ConcurrentLinkedList(
+    void (*deleteUserData)(ConcurrentLinkedList<T> *),
+    bool (*itemEqual)(T &, T &))
+{
+    this->deleteUserData = deleteUserData;
+    this->itemEqual = itemEqual;
+    this->tail = new Node();
+    this->head = new Node(tail);
+    this->count = 0;
+}
+
+template <class T>
+ConcurrentLinkedList<T>::~ConcurrentLinkedList()
+{
+    if (deleteUserData)
+    {
+        deleteUserData(this);
+    }
+    Node *current = head;
+    while (current != 0)
+    {
+        Node *next = current->next;
+        delete current;
+        current = next;
+    }
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::add(T e)
+{
+    Node *newTail = new Node();
+    std::lock_guard<std::mutex> guardTail(tailLock);
+    Node *last = tail;
+    std::lock_guard<std::mutex> guardLast(last->lock);
+    last->data = std::move(e);
+    last->next = newTail;
+    tail = newTail;
+    count++;
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::add(int index, T e)
+{
+    if (index < 0)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    Node *newNode = new Node(std::move(e));
+    Node *prev;
+    try
+    {
+        prev = lockNodeAt(index - 1);
+    }
+    catch (...)
+    {
+        delete newNode;
+        throw;
+    }
+    if (prev->next == 0)
+    {
+        // prev is the tail node: index > size()
+        prev->lock.unlock();
+        delete newNode;
+        throw out_of_range("Index is out of range!");
+    }
+    // the new node goes between prev and prev->next (possibly the tail node)
+    newNode->next = prev->next;
+    prev->next = newNode;
+    count++;
+    prev->lock.unlock();
+}
+
+template <class T>
+T ConcurrentLinkedList<T>::removeAt(int index)
+{
+    if (index < 0)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    Node *prev = lockNodeAt(index - 1);
+    Node *current = prev->next;
+    current->lock.lock();
+    if (current->next == 0)
+    {
+        current->lock.unlock();
+        prev->lock.unlock();
+        throw out_of_range("Index is out of range!");
+    }
+    prev->next = current->next;
+    count--;
+    prev->lock.unlock();
+    // nobody else can reach "current" now: any other thread would need prev's lock first
+    current->lock.unlock();
+    T item = std::move(current->data);
+    delete current;
+    return item;
+}
+
+template <class T>
+bool ConcurrentLinkedList<T>::removeItem(T item, void (*removeItemData)(T))
+{
+    int index;
+    Node *prev = lockBefore(item, index);
+    if (prev == 0)
+    {
+        return false;
+    }
+    Node *current = prev->next;
+    prev->next = current->next;
+    count--;
+    prev->lock.unlock();
+    current->lock.unlock();
+    if (removeItemData != 0)
+        removeItemData(current->data);
+    delete current;
+    return true;
+}
+
+template <class T>
+bool ConcurrentLinkedList<T>::empty()
+{
+    return count == 0;
+}
+
+template <class T>
+int ConcurrentLinkedList<T>::size()
+{
+    return count;
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::clear()
+{
+    head->lock.lock();
+    Node *current = head->next;
+    current->lock.lock();
+    while (current->next != 0)
+    {
+        // unlink "current" while holding head, then move on to the node behind it
+        Node *next = current->next;
+        next->lock.lock();
+        head->next = next;
+        count--;
+        current->lock.unlock();
+        delete current;
+        current = next;
+    }
+    current->lock.unlock();
+    head->lock.unlock();
+}
+
+template <class T>
+T &ConcurrentLinkedList<T>::get(int index)
+{
+    if (index < 0)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    Node *node = lockNodeAt(index);
+    if (node->next == 0)
+    {
+        node->lock.unlock();
+        throw out_of_range("Index is out of range!");
+    }
+    node->lock.unlock();
+    return node->data;
+}
+
+template <class T>
+T ConcurrentLinkedList<T>::valueAt(int index)
+{
+    if (index < 0)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    Node *node = lockNodeAt(index);
+    if (node->next == 0)
+    {
+        node->lock.unlock();
+        throw out_of_range("Index is out of range!");
+    }
+    T item = node->data;
+    node->lock.unlock();
+    return item;
+}
+
+template <class T>
+int ConcurrentLinkedList<T>::indexOf(T item)
+{
+    int index;
+    Node *prev = lockBefore(item, index);
+    if (prev == 0)
+    {
+        return -1;
+    }
+    prev->next->lock.unlock();
+    prev->lock.unlock();
+    return index;
+}
+
+template <class T>
+bool ConcurrentLinkedList<T>::contains(T item)
+{
+    return indexOf(std::move(item)) != -1;
+}
+
+template <class T>
+string ConcurrentLinkedList<T>::toString(string (*item2str)(T &))
+{
+    stringstream ss;
+    XFormatter<T> format;
+    bool first = true;
+    ss << "[";
+    forEach([&](T &item)
+            {
+                if (!first)
+                    ss << ", ";
+                first = false;
+                if (item2str != 0)
+                    ss << item2str(item);
+                else
+                    format(ss, item); });
+    ss << "]";
+    return ss.str();
+}
+
+template <class T>
+template <class Fn>
+void ConcurrentLinkedList<T>::forEach(Fn fn)
+{
+    Node *prev = head;
+    prev->lock.lock();
+    Node *current = prev->next;
+    current->lock.lock();
+    while (current->next != 0)
+    {
+        prev->lock.unlock();
+        fn(current->data);
+        prev = current;
+        current = current->next;
+        current->lock.lock();
+    }
+    current->lock.unlock();
+    prev->lock.unlock();
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::forEachItem(void (*visit)(const T &, void *), void *context)
+{
+    forEach([visit, context](T &item)
+            { visit(item, context); });
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::addAll(const T *items, int n)
+{
+    if (n <= 0)
+    {
+        return;
+    }
+    // everything is built before taking a lock: the first item goes into the
+    // current tail node, the others into a chain that ends with a new tail node
+    T firstItem(items[0]);
+    Node *newTail = new Node();
+    Node *chainLast;
+    Node *chain;
+    try
+    {
+        chain = newChain(items + 1, items + n, chainLast);
+    }
+    catch (...)
+    {
+        delete newTail;
+        throw;
+    }
+    std::lock_guard<std::mutex> guardTail(tailLock);
+    Node *last = tail;
+    std::lock_guard<std::mutex> guardLast(last->lock);
+    last->data = std::move(firstItem);
+    if (chain != 0)
+    {
+        chainLast->next = newTail;
+        last->next = chain;
+    }
+    else
+    {
+        last->next = newTail;
+    }
+    tail = newTail;
+    count += n;
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::addAll(IList<T> &list)
+{
+    // copy the items out first: "list" may be this list, or be changed by other threads
+    // while it is read, so the buffer grows with whatever forEachItem visits
+    XSortBuffer<T> items(list.size());
+    list.forEachItem([](const T &item, void *buffer)
+                     { static_cast<XSortBuffer<T> *>(buffer)->push(T(item)); },
+                     &items);
+    addAll(items.begin(), (int)(items.end() - items.begin()));
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::insertRange(int index, const T *first, const T *last)
+{
+    if (index < 0)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    Node *chainLast;
+    Node *chain = newChain(first, last, chainLast);
+    Node *prev;
+    try
+    {
+        prev = lockNodeAt(index - 1);
+    }
+    catch (...)
+    {
+        deleteChain(chain);
+        throw;
+    }
+    if (prev->next == 0)
+    {
+        // prev is the tail node: index > size()
+        prev->lock.unlock();
+        deleteChain(chain);
+        throw out_of_range("Index is out of range!");
+    }
+    if (chain != 0)
+    {
+        chainLast->next = prev->next;
+        prev->next = chain;
+        count += (int)(last - first);
+    }
+    prev->lock.unlock();
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::removeRange(int from, int to)
+{
+    if (from < 0 || from > to)
+    {
+        throw out_of_range("Range is out of range!");
+    }
+    Node *prev;
+    try
+    {
+        prev = lockNodeAt(from - 1);
+    }
+    catch (out_of_range &)
+    {
+        throw out_of_range("Range is out of range!");
+    }
+    if (prev->next == 0)
+    {
+        prev->lock.unlock();
+        throw out_of_range("Range is out of range!");
+    }
+    // walk the range hand over hand while prev stays locked: no other thread can
+    // enter it behind us, and the ones ahead of us have left it once we pass them
+    Node *current = prev->next;
+    current->lock.lock();
+    for (int idx = from; idx < to; idx++)
+    {
+        if (current->next == 0)
+        {
+            current->lock.unlock();
+            prev->lock.unlock();
+            throw out_of_range("Range is out of range!");
+        }
+        Node *next = current->next;
+        next->lock.lock();
+        current->lock.unlock();
+        current = next;
+    }
+    // current: the first node behind the range
+    Node *removed = prev->next;
+    prev->next = current;
+    count -= to - from;
+    current->lock.unlock();
+    prev->lock.unlock();
+    deleteChain(removed, current);
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::sort(bool (*comparator)(T &, T &))
+{
+    xsortCheck(comparator);
+    if (comparator != 0)
+    {
+        sortBy([comparator](T &lhs, T &rhs)
+               { return comparator(lhs, rhs); });
+    }
+    else
+    {
+        if constexpr (XHasLess<T>::value)
+            sortBy([](const T &lhs, const T &rhs)
+                   { return lhs < rhs; });
+    }
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::stableSort(bool (*comparator)(T &, T &))
+{
+    sort(comparator); // the merge sort is stable
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+typename ConcurrentLinkedList<T>::Node *ConcurrentLinkedList<T>::lockNodeAt(int index)
+{
+    Node *current = head;
+    current->lock.lock();
+    for (int i = -1; i < index; i++)
+    {
+        Node *next = current->next;
+        if (next == 0)
+        {
+            current->lock.unlock();
+            throw out_of_range("Index is out of range!");
+        }
+        next->lock.lock();
+        current->lock.unlock();
+        current = next;
+    }
+    return current;
+}
+
+template <class T>
+typename ConcurrentLinkedList<T>::Node *ConcurrentLinkedList<T>::lockBefore(T &item, int &index)
+{
+    Node *prev = head;
+    prev->lock.lock();
+    Node *current = prev->next;
+    current->lock.lock();
+    index = 0;
+    while (current->next != 0)
+    {
+        if (equals(current->data, item, itemEqual))
+        {
+            return prev;
+        }
+        prev->lock.unlock();
+        prev = current;
+        current = current->next;
+        current->lock.lock();
+        index++;
+    }
+    current->lock.unlock();
+    prev->lock.unlock();
+    return 0;
+}
+
+template <class T>
+typename ConcurrentLinkedList<T>::Node *ConcurrentLinkedList<T>::newChain(const T *first, const T *last, Node *&chainLast)
+{
+    Node *chain = 0;
+    Node **link = &chain;
+    chainLast = 0;
+    try
+    {
+        for (const T *ptr = first; ptr != last; ptr++)
+        {
+            chainLast = new Node(*ptr);
+            *link = chainLast;
+            link = &chainLast->next;
+        }
+    }
+    catch (...)
+    {
+        deleteChain(chain);
+        throw;
+    }
+    return chain;
+}
+
+template <class T>
+void ConcurrentLinkedList<T>::deleteChain(Node *node, Node *end)
+{
+    while (node != end)
+    {
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+template <class T>
+template <class Compare>
+void ConcurrentLinkedList<T>::sortBy(Compare less)
+{
+    // lock every node from head to tail: the links are ours until they are released
+    head->lock.lock();
+    Node *last = head;
+    while (last->next != 0)
+    {
+        last->next->lock.lock();
+        last = last->next;
+    }
+    Node *end = last; // the tail node
+
+    // bottom-up: runs[i] is a sorted run of 2^i nodes (or 0); each node is merged
+    // in like a binary counter, and runs[i] always holds nodes older than runs[i - 1]
+    Node *runs[64] = {0};
+    int used = 0;
+    Node *rest = head->next;
+    while (rest != end)
+    {
+        Node *run = rest;
+        rest = rest->next;
+        run->next = 0;
+        int level = 0;
+        for (; level < used && runs[level] != 0; level++)
+        {
+            run = mergeRuns(runs[level], run, less);
+            runs[level] = 0;
+        }
+        if (level == used)
+            used++;
+        runs[level] = run;
+    }
+    Node *sorted = 0;
+    for (int level = 0; level < used; level++)
+    {
+        if (runs[level] != 0)
+            sorted = sorted == 0 ? runs[level] : mergeRuns(runs[level], sorted, less);
+    }
+    Node *prevNode = head;
+    for (Node *node = sorted; node != 0; node = node->next)
+    {
+        prevNode->next = node;
+        prevNode = node;
+    }
+    prevNode->next = end;
+
+    // release from head to tail, reading each link before its node is unlocked
+    Node *node = head;
+    while (node != 0)
+    {
+        Node *next = node->next;
+        node->lock.unlock();
+        node = next;
+    }
+}
+
+template <class T>
+template <class Compare>
+typename ConcurrentLinkedList<T>::Node *ConcurrentLinkedList<T>::mergeRuns(Node *first, Node *second, Compare &less)
+{
+    Node *merged = 0;
+    Node **link = &merged;
+    while (first != 0 && second != 0)
+    {
+        if (less(second->data, first->data))
+        {
+            *link = second;
+            second = second->next;
+        }
+        else
+        {
+            *link = first;
+            first = first->next;
+        }
+        link = &(*link)->next;
+    }
+    *link = first != 0 ? first : second;
+    return merged;
+}
+
+#endif /* CONCURRENTLINKEDLIST_H */
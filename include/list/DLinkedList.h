@@ -3,33 +3,50 @@
 #define DLINKEDLIST_H
 
 #include "list/IList.h"
+#include "list/ListFormat.h"
+#include "list/ListPolicy.h"
+#include "list/NodePool.h"
+#include "list/ListSort.h"
+#include "list/ListStats.h"
 
 #include <sstream>
 #include <iostream>
 #include <type_traits>
+#include <utility>
+#include <iterator>
+#include <cstddef>
 using namespace std;
 
-template <class T>
+template <class T, class Pool = XSlabNodePool,
+          class Equal = XEqual<T>, class Formatter = XFormatter<T>>
 class DLinkedList : public IList<T>
 {
 public:
-    class Node;        // Forward declaration
-    class Iterator;    // Forward declaration
-    class BWDIterator; // Forward declaration
+    class Node;             // Forward declaration
+    class Iterator;         // Forward declaration
+    class ConstIterator;    // Forward declaration
+    class BWDIterator;      // Forward declaration
+    class ConstBWDIterator; // Forward declaration
 
 protected:
     Node *head; // this node does not contain user's data
     Node *tail; // this node does not contain user's data
     int count;
+    Node *finger;    // last node reached by an indexed lookup (0 if unknown)
+    int fingerIndex; // location of "finger"
+    Pool pool;  // storage of the data nodes (head and tail are allocated separately)
+#ifdef XLIST_INSTRUMENT
+    int lastWalk; // nodes walked by the last nodeAt
+#endif
     bool (*itemEqual)(T &lhs, T &rhs);        // function pointer: test if two items (type: T&) are equal or not
-    void (*deleteUserData)(DLinkedList<T> *); // function pointer: be called to remove items (if they are pointer type)
+    void (*deleteUserData)(DLinkedList<T, Pool, Equal, Formatter> *); // function pointer: be called to remove items (if they are pointer type)
 
 public:
     DLinkedList(
-        void (*deleteUserData)(DLinkedList<T> *) = 0,
+        void (*deleteUserData)(DLinkedList<T, Pool, Equal, Formatter> *) = 0,
         bool (*itemEqual)(T &, T &) = 0);
-    DLinkedList(const DLinkedList<T> &list);
-    DLinkedList<T> &operator=(const DLinkedList<T> &list);
+    DLinkedList(const DLinkedList<T, Pool, Equal, Formatter> &list);
+    DLinkedList<T, Pool, Equal, Formatter> &operator=(const DLinkedList<T, Pool, Equal, Formatter> &list);
     ~DLinkedList();
 
     // Inherit from IList: BEGIN
@@ -44,13 +61,30 @@ public:
     int indexOf(T item);
     bool contains(T item);
     string toString(string (*item2str)(T &) = 0);
+    void forEachItem(void (*visit)(const T &, void *), void *context);
+    void addAll(const T *items, int n);
+    void addAll(IList<T> &list);
+    void insertRange(int index, const T *first, const T *last);
+    void removeRange(int from, int to);
+    void sort(bool (*comparator)(T &, T &) = 0);
+    void stableSort(bool (*comparator)(T &, T &) = 0);
     // Inherit from IList: END
 
+    // sortBy(less): stable merge sort with any callable less(a, b); only the links
+    //      change, the items themselves are never copied or moved
+    template <class Compare>
+    void sortBy(Compare less);
+
+    // writeTo(os, item2str, maxItems): stream the list as toString() does, chunk by chunk;
+    //      at most maxItems items are written (-1: all), the rest is shown as "..."
+    void writeTo(ostream &os, string (*item2str)(T &) = 0, int maxItems = -1);
+
     void println(string (*item2str)(T &) = 0)
     {
-        cout << toString(item2str) << endl;
+        writeTo(cout, item2str);
+        cout << endl;
     }
-    void setDeleteUserDataPtr(void (*deleteUserData)(DLinkedList<T> *) = 0)
+    void setDeleteUserDataPtr(void (*deleteUserData)(DLinkedList<T, Pool, Equal, Formatter> *) = 0)
     {
         this->deleteUserData = deleteUserData;
     }
@@ -58,7 +92,7 @@ public:
     bool contains(T array[], int size)
     {
         int idx = 0;
-        for (DLinkedList<T>::Iterator it = begin(); it != end(); it++)
+        for (DLinkedList<T, Pool, Equal, Formatter>::Iterator it = begin(); it != end(); it++)
         {
             if (!equals(*it, array[idx++], this->itemEqual))
                 return false;
@@ -66,9 +100,9 @@ public:
         return true;
     }
 
-    static void free(DLinkedList<T> *list)
+    static void free(DLinkedList<T, Pool, Equal, Formatter> *list)
     {
-        typename DLinkedList<T>::Iterator it = list->begin();
+        typename DLinkedList<T, Pool, Equal, Formatter>::Iterator it = list->begin();
         while (it != list->end())
         {
             delete *it;
@@ -94,17 +128,83 @@ public:
         return BWDIterator(this, false);
     }
 
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+    ConstIterator begin() const
+    {
+        return ConstIterator(this, true);
+    }
+    ConstIterator end() const
+    {
+        return ConstIterator(this, false);
+    }
+    ConstIterator cbegin() const
+    {
+        return ConstIterator(this, true);
+    }
+    ConstIterator cend() const
+    {
+        return ConstIterator(this, false);
+    }
+    ConstBWDIterator bbegin() const
+    {
+        return ConstBWDIterator(this, true);
+    }
+    ConstBWDIterator bend() const
+    {
+        return ConstBWDIterator(this, false);
+    }
+
 protected:
     static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &))
     {
         if (itemEqual == 0)
-            return lhs == rhs;
+            return Equal()(lhs, rhs);
         else
             return itemEqual(lhs, rhs);
     }
-    void copyFrom(const DLinkedList<T> &list);
+    void copyFrom(const DLinkedList<T, Pool, Equal, Formatter> &list);
     void removeInternalData();
+
+    template <class... Args>
+    Node *createNode(Args &&...args)
+    {
+        XLIST_STAT(DLinkedList, allocations, 1);
+        XLIST_STAT(DLinkedList, bytes, sizeof(Node));
+#ifdef XLIST_INSTRUMENT
+        if (xlistItemCopied<Args...>())
+            XLIST_STAT(DLinkedList, copies, 1);
+        else
+            XLIST_STAT(DLinkedList, moves, 1);
+#endif
+        return new (pool.allocate()) Node(std::forward<Args>(args)...);
+    }
+    void destroyNode(Node *node)
+    {
+        XLIST_STAT(DLinkedList, frees, 1);
+        node->~Node();
+        pool.release(node);
+    }
+    // releaseNodes: destroy all data nodes; a bulk-release pool frees whole slabs at once
+    void releaseNodes();
     Node *getPreviousNodeOf(int index);
+    // findNode(item, index): first node holding "item" (0 if none) and its location
+    Node *findNode(T &item, int &index);
+    // nodeAt(index): node at location "index", walking from the nearest of head,
+    //      tail and the finger left by the previous lookup (so i, i+1, ... is O(1) per step);
+    //      index -1 gives head and index count gives tail
+    Node *nodeAt(int index);
+    void invalidateFinger()
+    {
+        finger = 0;
+        fingerIndex = -1;
+    }
+    // spliceBefore: link the chain [first, last] in front of "pos"
+    void spliceBefore(Node *pos, Node *first, Node *last, int n);
+    // mergeRuns: merge two sorted chains linked through "next" (0-terminated);
+    //      on ties the node of "first" comes first, which keeps the sort stable
+    template <class Compare>
+    static Node *mergeRuns(Node *first, Node *second, Compare &less);
 
     //////////////////////////////////////////////////////////////////////
     ////////////////////////  INNER CLASSES DEFNITION ////////////////////
@@ -116,7 +216,7 @@ public:
         T data;
         Node *next;
         Node *prev;
-        friend class DLinkedList<T>;
+        friend class DLinkedList<T, Pool, Equal, Formatter>;
 
     public:
         Node(Node *next = 0, Node *prev = 0)
@@ -124,23 +224,31 @@ public:
             this->next = next;
             this->prev = prev;
         }
-        Node(T data, Node *next = 0, Node *prev = 0)
+        Node(T data, Node *next = 0, Node *prev = 0) : data(std::move(data))
         {
-            this->data = data;
             this->next = next;
             this->prev = prev;
         }
     };
 
     //////////////////////////////////////////////////////////////////////
+    // Iterator, BWDIterator (and their const variants): bidirectional iterators,
+    // so the standard algorithms can walk the list in place
     class Iterator
     {
     private:
-        DLinkedList<T> *pList;
+        DLinkedList<T, Pool, Equal, Formatter> *pList;
         Node *pNode;
+        friend class ConstIterator;
 
     public:
-        Iterator(DLinkedList<T> *pList = 0, bool begin = true)
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T &reference;
+
+        Iterator(DLinkedList<T, Pool, Equal, Formatter> *pList = 0, bool begin = true)
         {
             if (begin)
             {
@@ -172,16 +280,25 @@ public:
             Node *pNext = pNode->prev; // MUST prev, so iterator++ will go to end
             if (removeItemData != 0)
                 removeItemData(pNode->data);
-            delete pNode;
+            pList->destroyNode(pNode);
+            pList->invalidateFinger();
             pNode = pNext;
             pList->count -= 1;
         }
 
-        T &operator*()
+        T &operator*() const
         {
             return pNode->data;
         }
-        bool operator!=(const Iterator &iterator)
+        T *operator->() const
+        {
+            return &pNode->data;
+        }
+        bool operator==(const Iterator &iterator) const
+        {
+            return pNode == iterator.pNode;
+        }
+        bool operator!=(const Iterator &iterator) const
         {
             return pNode != iterator.pNode;
         }
@@ -198,16 +315,101 @@ public:
             ++*this;
             return iterator;
         }
+        Iterator &operator--()
+        {
+            pNode = pNode->prev;
+            return *this;
+        }
+        Iterator operator--(int)
+        {
+            Iterator iterator = *this;
+            --*this;
+            return iterator;
+        }
+    };
+
+    class ConstIterator
+    {
+    private:
+        const DLinkedList<T, Pool, Equal, Formatter> *pList;
+        const Node *pNode;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        ConstIterator(const DLinkedList<T, Pool, Equal, Formatter> *pList = 0, bool begin = true)
+        {
+            if (pList != 0)
+                this->pNode = begin ? pList->head->next : pList->tail;
+            else
+                pNode = 0;
+            this->pList = pList;
+        }
+        ConstIterator(const Iterator &iterator)
+        {
+            this->pNode = iterator.pNode;
+            this->pList = iterator.pList;
+        }
+
+        const T &operator*() const
+        {
+            return pNode->data;
+        }
+        const T *operator->() const
+        {
+            return &pNode->data;
+        }
+        bool operator==(const ConstIterator &iterator) const
+        {
+            return pNode == iterator.pNode;
+        }
+        bool operator!=(const ConstIterator &iterator) const
+        {
+            return pNode != iterator.pNode;
+        }
+        ConstIterator &operator++()
+        {
+            pNode = pNode->next;
+            return *this;
+        }
+        ConstIterator operator++(int)
+        {
+            ConstIterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+        ConstIterator &operator--()
+        {
+            pNode = pNode->prev;
+            return *this;
+        }
+        ConstIterator operator--(int)
+        {
+            ConstIterator iterator = *this;
+            --*this;
+            return iterator;
+        }
     };
 
     class BWDIterator
     {
     private:
-        DLinkedList<T> *pList;
+        DLinkedList<T, Pool, Equal, Formatter> *pList;
         Node *pNode;
+        friend class ConstBWDIterator;
 
     public:
-        BWDIterator(DLinkedList<T> *pList = 0, bool begin = true)
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T &reference;
+
+        BWDIterator(DLinkedList<T, Pool, Equal, Formatter> *pList = 0, bool begin = true)
         {
             if (begin)
             {
@@ -248,23 +450,32 @@ public:
             {
                 removeItemData(pNode->data);
             }
-            delete pNode;
+            pList->destroyNode(pNode);
+            pList->invalidateFinger();
             pNode = pPrev;
             pList->count -= 1;
         }
-        T &operator*()
+        T &operator*() const
         {
             return pNode->data;
         }
-
-        bool operator!=(const BWDIterator &iterator)
+        T *operator->() const
+        {
+            return &pNode->data;
+        }
+        bool operator==(const BWDIterator &iterator) const
+        {
+            return pNode == iterator.pNode;
+        }
+        bool operator!=(const BWDIterator &iterator) const
         {
             return pNode != iterator.pNode;
         }
 
+        // -- steps back towards bbegin(), i.e. forward in the list
         BWDIterator &operator--()
         {
-            pNode = pNode->prev;
+            pNode = pNode->next;
             return *this;
         }
 
@@ -286,6 +497,73 @@ public:
             return bwditerator;
         }
     };
+
+    class ConstBWDIterator
+    {
+    private:
+        const DLinkedList<T, Pool, Equal, Formatter> *pList;
+        const Node *pNode;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        ConstBWDIterator(const DLinkedList<T, Pool, Equal, Formatter> *pList = 0, bool begin = true)
+        {
+            if (pList != 0)
+                this->pNode = begin ? pList->tail->prev : pList->head;
+            else
+                pNode = 0;
+            this->pList = pList;
+        }
+        ConstBWDIterator(const BWDIterator &iterator)
+        {
+            this->pNode = iterator.pNode;
+            this->pList = iterator.pList;
+        }
+
+        const T &operator*() const
+        {
+            return pNode->data;
+        }
+        const T *operator->() const
+        {
+            return &pNode->data;
+        }
+        bool operator==(const ConstBWDIterator &iterator) const
+        {
+            return pNode == iterator.pNode;
+        }
+        bool operator!=(const ConstBWDIterator &iterator) const
+        {
+            return pNode != iterator.pNode;
+        }
+        ConstBWDIterator &operator++()
+        {
+            pNode = pNode->prev;
+            return *this;
+        }
+        ConstBWDIterator operator++(int)
+        {
+            ConstBWDIterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+        ConstBWDIterator &operator--()
+        {
+            pNode = pNode->next;
+            return *this;
+        }
+        ConstBWDIterator operator--(int)
+        {
+            ConstBWDIterator iterator = *this;
+            --*this;
+            return iterator;
+        }
+    };
 };
 //////////////////////////////////////////////////////////////////////
 // Define a shorter name for DLinkedList:
@@ -297,13 +575,15 @@ using List = DLinkedList<T>;
 ////////////////////////     METHOD DEFNITION      ///////////////////
 //////////////////////////////////////////////////////////////////////
 
-template <class T>
-DLinkedList<T>::DLinkedList(
-    void (*deleteUserData)(DLinkedList<T> *), bool (*itemEqual)(T &, T &))
+template <class T, class Pool, class Equal, class Formatter>
+DLinkedList<T, Pool, Equal, Formatter>::DLinkedList(
+    void (*deleteUserData)(DLinkedList<T, Pool, Equal, Formatter> *), bool (*itemEqual)(T &, T &))
+    : pool(sizeof(Node), alignof(Node))
 {
     this->deleteUserData = deleteUserData;
     this->itemEqual = itemEqual;
     this->count = 0;
+    invalidateFinger();
 
     this->head = new Node();
     this->tail = new Node();
@@ -312,13 +592,15 @@ DLinkedList<T>::DLinkedList(
     tail->prev = head;
 }
 
-template <class T>
-DLinkedList<T>::DLinkedList(const DLinkedList<T> &list)
+template <class T, class Pool, class Equal, class Formatter>
+DLinkedList<T, Pool, Equal, Formatter>::DLinkedList(const DLinkedList<T, Pool, Equal, Formatter> &list)
+    : pool(sizeof(Node), alignof(Node))
 {
 
     this->deleteUserData = list.deleteUserData;
     this->itemEqual = list.itemEqual;
     this->count = 0;
+    invalidateFinger();
     // cout<<"HIIIII"<<endl;
     this->head = new Node();
     this->tail = new Node();
@@ -337,8 +619,8 @@ DLinkedList<T>::DLinkedList(const DLinkedList<T> &list)
     }
 }
 
-template <class T>
-DLinkedList<T> &DLinkedList<T>::operator=(const DLinkedList<T> &list)
+template <class T, class Pool, class Equal, class Formatter>
+DLinkedList<T, Pool, Equal, Formatter> &DLinkedList<T, Pool, Equal, Formatter>::operator=(const DLinkedList<T, Pool, Equal, Formatter> &list)
 {
     if (this == &list)
     {
@@ -359,26 +641,22 @@ DLinkedList<T> &DLinkedList<T>::operator=(const DLinkedList<T> &list)
     return *this;
 }
 
-template <class T>
-DLinkedList<T>::~DLinkedList()
+template <class T, class Pool, class Equal, class Formatter>
+DLinkedList<T, Pool, Equal, Formatter>::~DLinkedList()
 {
     if (deleteUserData)
     {
         deleteUserData(this);
     }
-    Node *current = head;
-    while (current != nullptr)
-    {
-        Node *nextNode = current->next;
-        delete current;
-        current = nextNode;
-    }
+    releaseNodes();
+    delete head;
+    delete tail;
 }
 
-template <class T>
-void DLinkedList<T>::add(T e)
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::add(T e)
 {
-    Node *newNode = new Node(e);
+    Node *newNode = createNode(std::move(e));
 
     tail->prev->next = newNode;
     newNode->prev = tail->prev;
@@ -388,151 +666,324 @@ void DLinkedList<T>::add(T e)
 
     count++;
 }
-template <class T>
-void DLinkedList<T>::add(int index, T e)
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::add(int index, T e)
 {
     if (index < 0 || index > count)
     {
         throw out_of_range("Index is out of range!");
     }
 
-    Node *newNode = new Node(e);
+    Node *nextNode = nodeAt(index);
+    Node *newNode = createNode(std::move(e), nextNode, nextNode->prev);
 
-    if (index == 0)
-    {
-        if (count == 0)
-        {
+    nextNode->prev->next = newNode;
+    nextNode->prev = newNode;
+    count++;
 
-            head->next = newNode;
-            newNode->prev = head;
+    finger = newNode;
+    fingerIndex = index;
+}
+template <class T, class Pool, class Equal, class Formatter>
+typename DLinkedList<T, Pool, Equal, Formatter>::Node *DLinkedList<T, Pool, Equal, Formatter>::getPreviousNodeOf(int index)
+{
+    if (index < 0 || index >= count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    return nodeAt(index - 1);
+}
+template <class T, class Pool, class Equal, class Formatter>
+T DLinkedList<T, Pool, Equal, Formatter>::removeAt(int index)
+{
+    if (index < 0 || index >= count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
 
-            newNode->next = tail;
-            tail->prev = newNode;
-        }
-        else
-        {
-            newNode->next = head->next;
-            head->next->prev = newNode;
+    Node *deleteNode = nodeAt(index);
+    XLIST_STAT(DLinkedList, removes, 1);
+    XLIST_STAT(DLinkedList, removeSteps, lastWalk);
+    deleteNode->prev->next = deleteNode->next;
+    deleteNode->next->prev = deleteNode->prev;
+    count--;
 
-            head->next = newNode;
-            newNode->prev = head;
-        }
+    // the next node now sits at "index"
+    if (index < count)
+    {
+        finger = deleteNode->next;
+        fingerIndex = index;
     }
-    else if (index == count)
+    else
     {
+        invalidateFinger();
+    }
 
-        newNode->prev = tail->prev;
-        tail->prev->next = newNode;
-
-        tail->prev = newNode;
-        newNode->next = tail;
+    T data = std::move(deleteNode->data);
+    destroyNode(deleteNode);
+    return data;
+}
+template <class T, class Pool, class Equal, class Formatter>
+typename DLinkedList<T, Pool, Equal, Formatter>::Node *DLinkedList<T, Pool, Equal, Formatter>::nodeAt(int index)
+{
+    Node *current;
+    int position;
+    int distance;
+    if (index + 1 <= count - index)
+    {
+        current = head;
+        position = -1;
+        distance = index + 1;
     }
     else
     {
+        current = tail;
+        position = count;
+        distance = count - index;
+    }
+    if (finger != 0 && (index > fingerIndex ? index - fingerIndex : fingerIndex - index) < distance)
+    {
+        current = finger;
+        position = fingerIndex;
+    }
+#ifdef XLIST_INSTRUMENT
+    lastWalk = index > position ? index - position : position - index;
+#endif
 
-        Node *prevNode = head->next;
+    while (position < index)
+    {
+        current = current->next;
+        position++;
+    }
+    while (position > index)
+    {
+        current = current->prev;
+        position--;
+    }
 
-        for (int i = 1; i <= index; i++)
-        {
+    if (index >= 0 && index < count)
+    {
+        finger = current;
+        fingerIndex = index;
+    }
+    return current;
+}
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::spliceBefore(Node *pos, Node *first, Node *last, int n)
+{
+    Node *prevNode = pos->prev;
 
-            if (index == i)
-            {
-                newNode->next = prevNode->next;
-                prevNode->next->prev = newNode;
+    prevNode->next = first;
+    first->prev = prevNode;
 
-                prevNode->next = newNode;
-                newNode->prev = prevNode;
-            }
+    last->next = pos;
+    pos->prev = last;
 
-            prevNode = prevNode->next;
-        }
-    }
-    count++;
+    count += n;
 }
 
-template <class T>
-typename DLinkedList<T>::Node *DLinkedList<T>::getPreviousNodeOf(int index)
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::forEachItem(void (*visit)(const T &, void *), void *context)
 {
-    if (index < 0 || index >= count)
-    {
-        throw out_of_range("Index is out of range!");
-    }
-    Node *current;
-    if (index < count / 2)
+    for (Node *node = head->next; node != tail; node = node->next)
+        visit(node->data, context);
+}
+
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::addAll(const T *items, int n)
+{
+    insertRange(count, items, items + n);
+}
+
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::addAll(IList<T> &list)
+{
+    int n = list.size();
+    if (n == 0)
+        return;
+
+    // build the whole chain first, then link it with a single splice
+    Node *first = 0, *last = 0;
+    DLinkedList<T, Pool, Equal, Formatter> *pLinked = dynamic_cast<DLinkedList<T, Pool, Equal, Formatter> *>(&list);
+    Node *source = pLinked != 0 ? pLinked->head->next : 0;
+    for (int idx = 0; idx < n; idx++)
     {
-        current = head->next;
-        for (int i = 0; i < index - 1; i++)
+        Node *newNode;
+        if (source != 0)
         {
-            current = current->next;
+            newNode = createNode(source->data);
+            source = source->next;
         }
-    }
-    else
-    {
-        current = tail->prev;
-        for (int i = count - 1; i > index - 1; i--)
+        else
+        {
+            newNode = createNode(list.get(idx));
+        }
+        if (last == 0)
         {
-            current = current->prev;
+            first = newNode;
         }
+        else
+        {
+            last->next = newNode;
+            newNode->prev = last;
+        }
+        last = newNode;
     }
-
-    return current;
+    spliceBefore(tail, first, last, n);
 }
 
-template <class T>
-T DLinkedList<T>::removeAt(int index)
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::insertRange(int index, const T *first, const T *last)
 {
-    if (index < 0 || index >= count)
+    if (index < 0 || index > count)
     {
         throw out_of_range("Index is out of range!");
     }
+    int n = last - first;
+    if (n <= 0)
+        return;
 
-    Node *deleteNode;
-    T data;
+    Node *chainFirst = createNode(*first);
+    Node *chainLast = chainFirst;
+    for (const T *ptr = first + 1; ptr != last; ptr++)
+    {
+        Node *newNode = createNode(*ptr, nullptr, chainLast);
+        chainLast->next = newNode;
+        chainLast = newNode;
+    }
+    spliceBefore(nodeAt(index), chainFirst, chainLast, n);
+    invalidateFinger();
+}
 
-    if (index == 0)
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::removeRange(int from, int to)
+{
+    if (from < 0 || to > count || from > to)
     {
-        deleteNode = head->next;
+        throw out_of_range("Range is out of range!");
+    }
+    if (from == to)
+        return;
 
-        head->next = deleteNode->next;
-        deleteNode->next->prev = head;
+    Node *first = nodeAt(from);
+    Node *last = first;
+    for (int i = from + 1; i < to; i++)
+    {
+        last = last->next;
     }
 
-    else if (index == count - 1)
+    // unlink [first, last] in one step, then free the detached chain
+    first->prev->next = last->next;
+    last->next->prev = first->prev;
+    last->next = 0;
+    count -= to - from;
+    invalidateFinger();
+
+    while (first != 0)
     {
-        deleteNode = tail->prev;
+        Node *nextNode = first->next;
+        destroyNode(first);
+        first = nextNode;
+    }
+}
 
-        tail->prev = deleteNode->prev;
-        deleteNode->prev->next = tail;
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::sort(bool (*comparator)(T &, T &))
+{
+    xsortCheck(comparator);
+    if (comparator != 0)
+    {
+        sortBy([comparator](T &lhs, T &rhs)
+               { return comparator(lhs, rhs); });
     }
     else
     {
+        if constexpr (XHasLess<T>::value)
+            sortBy([](const T &lhs, const T &rhs)
+                   { return lhs < rhs; });
+    }
+}
 
-        Node *prevNode = head->next;
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::stableSort(bool (*comparator)(T &, T &))
+{
+    sort(comparator); // the merge sort is stable
+}
 
-        for (int i = 1; i <= index; i++)
+template <class T, class Pool, class Equal, class Formatter>
+template <class Compare>
+void DLinkedList<T, Pool, Equal, Formatter>::sortBy(Compare less)
+{
+    if (count < 2)
+        return;
+
+    // bottom-up: runs[i] is a sorted run of 2^i nodes (or 0); each node is merged
+    // in like a binary counter, and runs[i] always holds nodes older than runs[i - 1]
+    Node *runs[64] = {0};
+    int used = 0;
+    tail->prev->next = 0;
+    Node *rest = head->next;
+    while (rest != 0)
+    {
+        Node *run = rest;
+        rest = rest->next;
+        run->next = 0;
+        int level = 0;
+        for (; level < used && runs[level] != 0; level++)
         {
-
-            if (i == index)
-            {
-                deleteNode = prevNode->next;
-
-                prevNode->next = deleteNode->next;
-                deleteNode->next->prev = prevNode;
-            }
-
-            prevNode = prevNode->next;
+            run = mergeRuns(runs[level], run, less);
+            runs[level] = 0;
         }
+        if (level == used)
+            used++;
+        runs[level] = run;
+    }
+    Node *sorted = 0;
+    for (int level = 0; level < used; level++)
+    {
+        if (runs[level] != 0)
+            sorted = sorted == 0 ? runs[level] : mergeRuns(runs[level], sorted, less);
     }
 
-    data = deleteNode->data;
-    delete deleteNode;
-    count--;
+    // restore the prev links and the sentinels
+    Node *prevNode = head;
+    for (Node *node = sorted; node != 0; node = node->next)
+    {
+        prevNode->next = node;
+        node->prev = prevNode;
+        prevNode = node;
+    }
+    prevNode->next = tail;
+    tail->prev = prevNode;
+    invalidateFinger();
+}
 
-    return data;
+template <class T, class Pool, class Equal, class Formatter>
+template <class Compare>
+typename DLinkedList<T, Pool, Equal, Formatter>::Node *DLinkedList<T, Pool, Equal, Formatter>::mergeRuns(Node *first, Node *second, Compare &less)
+{
+    Node *merged = 0;
+    Node **link = &merged;
+    while (first != 0 && second != 0)
+    {
+        if (less(second->data, first->data))
+        {
+            *link = second;
+            second = second->next;
+        }
+        else
+        {
+            *link = first;
+            first = first->next;
+        }
+        link = &(*link)->next;
+    }
+    *link = first != 0 ? first : second;
+    return merged;
 }
 
-template <class T>
-bool DLinkedList<T>::empty()
+template <class T, class Pool, class Equal, class Formatter>
+bool DLinkedList<T, Pool, Equal, Formatter>::empty()
 {
     if (count == 0)
     {
@@ -544,104 +995,85 @@ bool DLinkedList<T>::empty()
     }
 }
 
-template <class T>
-int DLinkedList<T>::size()
+template <class T, class Pool, class Equal, class Formatter>
+int DLinkedList<T, Pool, Equal, Formatter>::size()
 {
     return count;
 }
 
-template <class T>
-void DLinkedList<T>::clear()
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::clear()
 {
-    while (!empty())
-    {
-        removeAt(0);
-    }
+    releaseNodes();
 }
 
-template <class T>
-T &DLinkedList<T>::get(int index)
+template <class T, class Pool, class Equal, class Formatter>
+T &DLinkedList<T, Pool, Equal, Formatter>::get(int index)
 {
     if (index < 0 || index >= count)
     {
         throw out_of_range("Index is out of range!");
     }
-    Node *current = head->next;
-    for (int i = 0; i < index; i++)
-    {
-        current = current->next;
-    }
-
-    return current->data;
+    Node *node = nodeAt(index);
+    XLIST_STAT(DLinkedList, gets, 1);
+    XLIST_STAT(DLinkedList, getSteps, lastWalk);
+    return node->data;
+}
+template <class T, class Pool, class Equal, class Formatter>
+int DLinkedList<T, Pool, Equal, Formatter>::indexOf(T item)
+{
+    int index;
+    findNode(item, index);
+    XLIST_STAT(DLinkedList, indexOfs, 1);
+    XLIST_STAT(DLinkedList, indexOfScanned, index == -1 ? count : index + 1);
+    return index;
 }
 
-template <class T>
-int DLinkedList<T>::indexOf(T item)
-{
-    // Node* current = head->next;
-    // int i = 0;
-
-    // while (current != tail){
-    //     if(current->data == item){
-    //         return i;
-    //     }
-    //     i++;
-    //     current = current->next;
-    // }
-    // return -1;
-    Node *current = head->next;
-    int i = 0;
-
-    while (current != tail)
+template <class T, class Pool, class Equal, class Formatter>
+typename DLinkedList<T, Pool, Equal, Formatter>::Node *DLinkedList<T, Pool, Equal, Formatter>::findNode(T &item, int &index)
+{
+    // test the function pointer once, so the default scan can be inlined
+    index = 0;
+    if (itemEqual != 0)
     {
-        if (equals(current->data, item, itemEqual))
+        for (Node *current = head->next; current != tail; current = current->next, index++)
         {
-            return i;
+            if (itemEqual(current->data, item))
+                return current;
         }
-        i++;
-        current = current->next;
     }
-    return -1;
-}
-
-template <class T>
-bool DLinkedList<T>::removeItem(T item, void (*removeItemData)(T))
-{
-    Node *current = head->next;
-
-    while (current != tail)
+    else
     {
-
-        // if(current->data == item){
-        //     current->prev->next = current->next;
-        //     current->next->prev = current->prev;
-
-        //     if(removeItemData){
-        //         removeItemData(current->data);
-        //     }
-
-        //     delete current;
-        //     count--;
-
-        //     return true;
-        // }
-
-        if (equals(current->data, item, itemEqual))
+        Equal equal;
+        for (Node *current = head->next; current != tail; current = current->next, index++)
         {
-            current->prev->next = current->next;
-            current->next->prev = current->prev;
-            delete current;
-            count--;
-            return true;
+            if (equal(current->data, item))
+                return current;
         }
+    }
+    index = -1;
+    return 0;
+}
 
-        current = current->next;
+template <class T, class Pool, class Equal, class Formatter>
+bool DLinkedList<T, Pool, Equal, Formatter>::removeItem(T item, void (*removeItemData)(T))
+{
+    int index;
+    Node *current = findNode(item, index);
+    if (current == 0)
+    {
+        return false;
     }
-    return false;
+    current->prev->next = current->next;
+    current->next->prev = current->prev;
+    destroyNode(current);
+    invalidateFinger();
+    count--;
+    return true;
 }
 
-template <class T>
-bool DLinkedList<T>::contains(T item)
+template <class T, class Pool, class Equal, class Formatter>
+bool DLinkedList<T, Pool, Equal, Formatter>::contains(T item)
 {
     if (indexOf(item) != -1)
     {
@@ -653,36 +1085,27 @@ bool DLinkedList<T>::contains(T item)
     }
 }
 
-template <class T>
-string DLinkedList<T>::toString(string (*item2str)(T &))
+template <class T, class Pool, class Equal, class Formatter>
+string DLinkedList<T, Pool, Equal, Formatter>::toString(string (*item2str)(T &))
 {
     stringstream ss;
-    ss << "[";
+    writeTo(ss, item2str);
+    return ss.str();
+}
 
-    Node *current = head->next;
-    while (current != tail)
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::writeTo(ostream &os, string (*item2str)(T &), int maxItems)
+{
+    XListWriter<T, Formatter> writer(os, item2str, maxItems);
+    for (Node *current = head->next; current != tail && !writer.full(); current = current->next)
     {
-        if (item2str)
-        {
-            ss << item2str(current->data);
-        }
-        else
-        {
-            ss << current->data;
-        }
-
-        current = current->next;
-        if (current != tail)
-        {
-            ss << ", ";
-        }
+        writer.item(current->data);
     }
-    ss << "]";
-    return ss.str();
+    writer.finish(count);
 }
 
-template <class T>
-void DLinkedList<T>::copyFrom(const DLinkedList<T> &list)
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::copyFrom(const DLinkedList<T, Pool, Equal, Formatter> &list)
 {
 
     Node *current = list.head->next;
@@ -693,16 +1116,32 @@ void DLinkedList<T>::copyFrom(const DLinkedList<T> &list)
     }
 }
 
-template <class T>
-void DLinkedList<T>::removeInternalData()
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::removeInternalData()
 {
-    Node *current = head->next;
-    while (current != tail)
+    releaseNodes();
+}
+
+template <class T, class Pool, class Equal, class Formatter>
+void DLinkedList<T, Pool, Equal, Formatter>::releaseNodes()
+{
+    if (!Pool::bulkRelease || !std::is_trivially_destructible<T>::value)
     {
-        Node *nextNode = current->next;
-        delete current;
-        current = nextNode;
+        Node *current = head->next;
+        while (current != tail)
+        {
+            Node *nextNode = current->next;
+            if (Pool::bulkRelease)
+                current->~Node();
+            else
+                destroyNode(current);
+            current = nextNode;
+        }
     }
+    if (Pool::bulkRelease)
+        XLIST_STAT(DLinkedList, frees, count);
+    pool.releaseAll();
+    invalidateFinger();
 
     head->next = tail;
     tail->prev = head;
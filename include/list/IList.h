@@ -15,6 +15,8 @@
 #ifndef ILIST_H
 #define ILIST_H
 #include <string>
+#include <stdexcept>
+#include "list/ListSort.h"
 using namespace std;
 
 template<class T>
@@ -101,6 +103,88 @@ public:
      *          that can convert the item (passed to that function) to a string
      */
     virtual string  toString(string (*item2str)(T&)=0 )=0;
+    
+    
+    
+    /* forEachItem(void (*visit)(const T&, void*), void* context): call visit(item, context)
+     *      for every item, in order, without changing the list
+     *   >> the version here calls get() at every location; implementations override it
+     *      to walk their storage (linked lists) or to read it without copying it (arrays)
+     */
+    virtual void    forEachItem(void (*visit)(const T&, void*), void* context){
+        int n = size();
+        for(int idx=0; idx < n; idx++) visit(get(idx), context);
+    }
+    
+    
+    
+    /* Bulk operations: the versions here are generic fallbacks built on add/removeAt;
+     * implementations override them to move a whole range with a single
+     * reallocation/shift (array) or a single splice (linked list).
+     */
+    
+    /* addAll(const T* items, int n): append the n items in "items" to the list
+     */
+    virtual void    addAll(const T* items, int n){
+        insertRange(size(), items, items + n);
+    }
+    
+    
+    
+    /* addAll(IList<T>& list): append all items of "list" to the list
+     */
+    virtual void    addAll(IList<T>& list){
+        int n = list.size();
+        for(int idx=0; idx < n; idx++) add(list.get(idx));
+    }
+    
+    
+    
+    /* insertRange(int index, const T* first, const T* last): insert the items in [first, last)
+     *      at location "index", keeping their order
+     *  >> throw an exception (std::out_of_range) if index is invalid
+     */
+    virtual void    insertRange(int index, const T* first, const T* last){
+        if(index < 0 || index > size()) throw std::out_of_range("Index is out of range!");
+        for(const T* ptr=first; ptr != last; ptr++) add(index++, *ptr);
+    }
+    
+    
+    
+    /* removeRange(int from, int to): remove the items at locations [from, to)
+     *  >> throw an exception (std::out_of_range) if the range is invalid
+     */
+    virtual void    removeRange(int from, int to){
+        if(from < 0 || to > size() || from > to) throw std::out_of_range("Range is out of range!");
+        for(int idx=from; idx < to; idx++) removeAt(from);
+    }
+    
+    
+    
+    /* sort(bool (*comparator)(T&, T&)=0): arrange the items in increasing order
+     *   >> comparator(a, b): true if a must come before b; 0 (default) uses operator<
+     *   >> throw an exception (std::invalid_argument) if comparator is 0 and T has no operator<
+     * stableSort(...): the same, but equal items keep their relative order
+     * 
+     * The versions here move the items into a buffer, sort it and move them back;
+     * implementations override them to sort in place.
+     */
+    virtual void    sort(bool (*comparator)(T&, T&)=0){
+        sortThroughBuffer(comparator, false);
+    }
+    virtual void    stableSort(bool (*comparator)(T&, T&)=0){
+        sortThroughBuffer(comparator, true);
+    }
+    
+protected:
+    void sortThroughBuffer(bool (*comparator)(T&, T&), bool stable){
+        xsortCheck(comparator);
+        int n = size();
+        XSortBuffer<T> items(n);
+        for(int idx=0; idx < n; idx++) items.push(std::move(get(idx)));
+        xsortRange(items.begin(), items.end(), comparator, stable);
+        for(int idx=0; idx < n; idx++) get(idx) = std::move(items[idx]);
+    }
 };
 #endif /* ILIST_H */
 
@@ -0,0 +1,455 @@
+/*
+ * File:   IndexedArrayList.h
+ *
+ * An XArrayList paired with an open-addressing hash table from item to
+ * location, so indexOf/contains/removeItem cost O(1) on average instead of
+ * a full scan. The table is kept up to date by every list operation:
+ * appends and removals at the end are O(1); insertions/removals in the middle
+ * already shift O(n) items and shift the stored locations in the same pass.
+ *
+ * The table is only used when Hash is not void and no itemEqual function
+ * pointer is given (a pointer equality cannot be matched by a hash); otherwise
+ * the list falls back to the plain scan of XArrayList.
+ *
+ * NOTE: an item changed through get(index) must be followed by reindex().
+ */
+
+#ifndef INDEXEDARRAYLIST_H
+#define INDEXEDARRAYLIST_H
+
+#include "list/XArrayList.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+using namespace std;
+
+template <class T, class Hash = XHash<T>, class Equal = XEqual<T>>
+class IndexedArrayList : public IList<T>
+{
+public:
+    typedef XArrayList<T, std::allocator<T>, XGrowDouble, Equal> ArrayList;
+
+protected:
+    // Entry: one slot of the table; "index" is -1 for a free slot, -2 for a deleted one
+    struct Entry
+    {
+        int index;
+        size_t hash;
+    };
+    static const int FREE = -1;
+    static const int DELETED = -2;
+
+    ArrayList list;         // the items, in list order
+    Entry *table;           // open addressing, linear probing; size is a power of 2
+    int tableSize;          // number of slots
+    int tableUsed;          // slots that are not FREE (live + DELETED)
+    bool (*itemEqual)(T &lhs, T &rhs);                         // function pointer: test if two items (type: T&) are equal or not
+    void (*deleteUserData)(IndexedArrayList<T, Hash, Equal> *); // function pointer: be called to remove items (if they are pointer type)
+
+public:
+    IndexedArrayList(
+        void (*deleteUserData)(IndexedArrayList<T, Hash, Equal> *) = 0,
+        bool (*itemEqual)(T &, T &) = 0,
+        int capacity = 10);
+    IndexedArrayList(const IndexedArrayList<T, Hash, Equal> &list);
+    IndexedArrayList<T, Hash, Equal> &operator=(const IndexedArrayList<T, Hash, Equal> &list);
+    ~IndexedArrayList();
+
+    // Inherit from IList: BEGIN
+    void add(T e);
+    void add(int index, T e);
+    T removeAt(int index);
+    bool removeItem(T item, void (*removeItemData)(T) = 0);
+    bool empty();
+    int size();
+    void clear();
+    T &get(int index);
+    int indexOf(T item);
+    bool contains(T item);
+    string toString(string (*item2str)(T &) = 0);
+    void addAll(const T *items, int n);
+    void addAll(IList<T> &list);
+    void insertRange(int index, const T *first, const T *last);
+    void removeRange(int from, int to);
+    void sort(bool (*comparator)(T &, T &) = 0);
+    void stableSort(bool (*comparator)(T &, T &) = 0);
+    // Inherit from IList: END
+
+    // reindex(): rebuild the table from the items (after changing items through get)
+    void reindex();
+
+    // writeTo(os, item2str, maxItems): stream the list as toString() does, chunk by chunk;
+    //      at most maxItems items are written (-1: all), the rest is shown as "..."
+    void writeTo(ostream &os, string (*item2str)(T &) = 0, int maxItems = -1);
+
+    void println(string (*item2str)(T &) = 0)
+    {
+        writeTo(cout, item2str);
+        cout << endl;
+    }
+    void setDeleteUserDataPtr(void (*deleteUserData)(IndexedArrayList<T, Hash, Equal> *) = 0)
+    {
+        this->deleteUserData = deleteUserData;
+    }
+
+    static void free(IndexedArrayList<T, Hash, Equal> *list)
+    {
+        for (int idx = 0; idx < list->size(); idx++)
+        {
+            delete list->get(idx);
+        }
+    }
+
+protected:
+    // hashed(): true if lookups go through the table
+    bool hashed()
+    {
+        return !std::is_void<Hash>::value && itemEqual == 0;
+    }
+    // hashOf: Hash, scrambled so that identity hashes (std::hash<int>) do not form long probe runs
+    static size_t hashOf(const T &item)
+    {
+        if constexpr (!std::is_void<Hash>::value)
+        {
+            uint64_t h = static_cast<uint64_t>(Hash()(item));
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return static_cast<size_t>(h);
+        }
+        else
+            return 0;
+    }
+    void allocateTable(int minItems);
+    void insertEntry(int index, size_t hash);
+    void eraseEntry(int index, size_t hash);
+    // shiftEntries: add "delta" to every stored location >= from
+    void shiftEntries(int from, int delta);
+    int findFirst(T &item);
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T, class Hash, class Equal>
+IndexedArrayList<T, Hash, Equal>::IndexedArrayList(
+    void (*deleteUserData)(IndexedArrayList<T, Hash, Equal> *),
+    bool (*itemEqual)(T &, T &),
+    int capacity)
+    : list(0, itemEqual, capacity)
+{
+    this->deleteUserData = deleteUserData;
+    this->itemEqual = itemEqual;
+    this->table = 0;
+    this->tableSize = 0;
+    this->tableUsed = 0;
+    if (hashed())
+        allocateTable(capacity);
+}
+
+template <class T, class Hash, class Equal>
+IndexedArrayList<T, Hash, Equal>::IndexedArrayList(const IndexedArrayList<T, Hash, Equal> &list)
+    : list(list.list)
+{
+    this->deleteUserData = list.deleteUserData;
+    this->itemEqual = list.itemEqual;
+    this->table = 0;
+    this->tableSize = 0;
+    this->tableUsed = 0;
+    reindex();
+}
+
+template <class T, class Hash, class Equal>
+IndexedArrayList<T, Hash, Equal> &IndexedArrayList<T, Hash, Equal>::operator=(const IndexedArrayList<T, Hash, Equal> &list)
+{
+    if (this != &list)
+    {
+        this->list = list.list;
+        this->deleteUserData = list.deleteUserData;
+        this->itemEqual = list.itemEqual;
+        reindex();
+    }
+    return *this;
+}
+
+template <class T, class Hash, class Equal>
+IndexedArrayList<T, Hash, Equal>::~IndexedArrayList()
+{
+    if (deleteUserData)
+    {
+        deleteUserData(this);
+    }
+    delete[] table;
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::add(T e)
+{
+    list.add(std::move(e));
+    if (hashed())
+    {
+        int index = list.size() - 1;
+        insertEntry(index, hashOf(list.get(index)));
+    }
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::add(int index, T e)
+{
+    list.add(index, std::move(e));
+    if (hashed())
+    {
+        if (index < list.size() - 1)
+            shiftEntries(index, 1);
+        insertEntry(index, hashOf(list.get(index)));
+    }
+}
+
+template <class T, class Hash, class Equal>
+T IndexedArrayList<T, Hash, Equal>::removeAt(int index)
+{
+    if (hashed() && index >= 0 && index < list.size())
+    {
+        eraseEntry(index, hashOf(list.get(index)));
+        T item = list.removeAt(index);
+        if (index < list.size())
+            shiftEntries(index + 1, -1);
+        return item;
+    }
+    return list.removeAt(index);
+}
+
+template <class T, class Hash, class Equal>
+bool IndexedArrayList<T, Hash, Equal>::removeItem(T item, void (*removeItemData)(T))
+{
+    int index = indexOf(item);
+    if (index == -1)
+    {
+        return false;
+    }
+    T removed = removeAt(index);
+    if (removeItemData != 0)
+        removeItemData(removed);
+    return true;
+}
+
+template <class T, class Hash, class Equal>
+bool IndexedArrayList<T, Hash, Equal>::empty()
+{
+    return list.empty();
+}
+
+template <class T, class Hash, class Equal>
+int IndexedArrayList<T, Hash, Equal>::size()
+{
+    return list.size();
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::clear()
+{
+    list.clear();
+    for (int i = 0; i < tableSize; i++)
+        table[i].index = FREE;
+    tableUsed = 0;
+}
+
+template <class T, class Hash, class Equal>
+T &IndexedArrayList<T, Hash, Equal>::get(int index)
+{
+    return list.get(index);
+}
+
+template <class T, class Hash, class Equal>
+int IndexedArrayList<T, Hash, Equal>::indexOf(T item)
+{
+    if (hashed())
+    {
+        return findFirst(item);
+    }
+    return list.indexOf(item);
+}
+
+template <class T, class Hash, class Equal>
+bool IndexedArrayList<T, Hash, Equal>::contains(T item)
+{
+    return indexOf(item) != -1;
+}
+
+template <class T, class Hash, class Equal>
+string IndexedArrayList<T, Hash, Equal>::toString(string (*item2str)(T &))
+{
+    return list.toString(item2str);
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::writeTo(ostream &os, string (*item2str)(T &), int maxItems)
+{
+    list.writeTo(os, item2str, maxItems);
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::addAll(const T *items, int n)
+{
+    insertRange(list.size(), items, items + n);
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::addAll(IList<T> &list)
+{
+    int from = this->list.size();
+    this->list.addAll(list);
+    if (hashed())
+    {
+        for (int index = from; index < this->list.size(); index++)
+            insertEntry(index, hashOf(this->list.get(index)));
+    }
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::insertRange(int index, const T *first, const T *last)
+{
+    int n = last - first;
+    list.insertRange(index, first, last);
+    if (hashed() && n > 0)
+    {
+        if (index < list.size() - n)
+            shiftEntries(index, n);
+        for (int i = index; i < index + n; i++)
+            insertEntry(i, hashOf(list.get(i)));
+    }
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::removeRange(int from, int to)
+{
+    list.removeRange(from, to);
+    if (hashed() && from < to)
+        reindex();
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::sort(bool (*comparator)(T &, T &))
+{
+    list.sort(comparator);
+    if (hashed())
+        reindex();
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::stableSort(bool (*comparator)(T &, T &))
+{
+    list.stableSort(comparator);
+    if (hashed())
+        reindex();
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::reindex()
+{
+    delete[] table;
+    table = 0;
+    tableSize = tableUsed = 0;
+    if (!hashed())
+        return;
+    allocateTable(list.size());
+    // read through the const buffer: a copy keeps sharing it copy-on-write
+    const T *items = static_cast<const ArrayList &>(list).rawData();
+    for (int index = 0; index < list.size(); index++)
+        insertEntry(index, hashOf(items[index]));
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::allocateTable(int minItems)
+{
+    // keep the load factor (live + deleted) under 3/4
+    int newSize = 16;
+    while (newSize / 4 * 3 <= minItems)
+        newSize *= 2;
+    Entry *oldTable = table;
+    int oldSize = tableSize;
+
+    table = new Entry[newSize];
+    tableSize = newSize;
+    tableUsed = 0;
+    for (int i = 0; i < newSize; i++)
+        table[i].index = FREE;
+    for (int i = 0; i < oldSize; i++)
+    {
+        if (oldTable[i].index >= 0)
+            insertEntry(oldTable[i].index, oldTable[i].hash);
+    }
+    delete[] oldTable;
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::insertEntry(int index, size_t hash)
+{
+    if ((tableUsed + 1) * 4 > tableSize * 3)
+    {
+        allocateTable(list.size());
+    }
+    size_t mask = tableSize - 1;
+    size_t slot = hash & mask;
+    while (table[slot].index >= 0)
+        slot = (slot + 1) & mask;
+    if (table[slot].index == FREE)
+        tableUsed++;
+    table[slot].index = index;
+    table[slot].hash = hash;
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::eraseEntry(int index, size_t hash)
+{
+    size_t mask = tableSize - 1;
+    for (size_t slot = hash & mask; table[slot].index != FREE; slot = (slot + 1) & mask)
+    {
+        if (table[slot].index == index)
+        {
+            table[slot].index = DELETED;
+            return;
+        }
+    }
+}
+
+template <class T, class Hash, class Equal>
+void IndexedArrayList<T, Hash, Equal>::shiftEntries(int from, int delta)
+{
+    for (int i = 0; i < tableSize; i++)
+    {
+        if (table[i].index >= from)
+            table[i].index += delta;
+    }
+}
+
+template <class T, class Hash, class Equal>
+int IndexedArrayList<T, Hash, Equal>::findFirst(T &item)
+{
+    // duplicates have one entry each: keep the smallest location
+    size_t hash = hashOf(item);
+    size_t mask = tableSize - 1;
+    Equal equal;
+    int found = -1;
+    const T *items = static_cast<const ArrayList &>(list).rawData(); // a lookup must not detach a shared buffer
+    for (size_t slot = hash & mask; table[slot].index != FREE; slot = (slot + 1) & mask)
+    {
+        int index = table[slot].index;
+        if (index >= 0 && table[slot].hash == hash && (found == -1 || index < found) &&
+            equal(const_cast<T &>(items[index]), item))
+        {
+            found = index;
+        }
+    }
+    return found;
+}
+
+#endif /* INDEXEDARRAYLIST_H */
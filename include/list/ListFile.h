@@ -0,0 +1,184 @@
+/*
+ * File:   ListFile.h
+ *
+ * Binary file format of XArrayList::save/load/mapFile: a 64-byte header
+ * followed by the raw bytes of the items.
+ *
+ *      magic       8 bytes  "XLIST" + 3 zero bytes
+ *      version     uint32   XLIST_FILE_VERSION
+ *      itemSize    uint32   sizeof(T) of the writer
+ *      count       uint64   number of items
+ *      byteOrder   uint32   0x01020304 in the writer's byte order
+ *      (zero padding up to 64 bytes, so the items stay aligned in a mapping)
+ *
+ * Files are only read back on a machine with the same byte order and item
+ * size; anything else is rejected with std::runtime_error.
+ */
+
+#ifndef LISTFILE_H
+#define LISTFILE_H
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+#include <string>
+using namespace std;
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XLIST_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint32_t XLIST_FILE_VERSION = 1;
+static const uint32_t XLIST_BYTE_ORDER = 0x01020304;
+
+struct XListFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t itemSize;
+    uint64_t count;
+    uint32_t byteOrder;
+    char padding[36];
+};
+static_assert(sizeof(XListFileHeader) == 64, "XListFileHeader must be 64 bytes");
+
+// XListMapping: a file mapped by xlistMapFile; base is 0 when nothing is mapped
+struct XListMapping
+{
+    void *base;
+    size_t length;
+};
+
+inline XListFileHeader xlistMakeHeader(size_t itemSize, uint64_t count)
+{
+    XListFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "XLIST", 5);
+    header.version = XLIST_FILE_VERSION;
+    header.itemSize = static_cast<uint32_t>(itemSize);
+    header.count = count;
+    header.byteOrder = XLIST_BYTE_ORDER;
+    return header;
+}
+
+// xlistCheckHeader: throw std::runtime_error unless "header" describes items of itemSize bytes
+inline void xlistCheckHeader(const XListFileHeader &header, size_t itemSize)
+{
+    if (memcmp(header.magic, "XLIST\0\0\0", 8) != 0)
+        throw runtime_error("Not a list file!");
+    if (header.version != XLIST_FILE_VERSION)
+        throw runtime_error("Unsupported list file version!");
+    if (header.byteOrder != XLIST_BYTE_ORDER || header.itemSize != itemSize)
+        throw runtime_error("List file was written for another item type or byte order!");
+    if (header.count > static_cast<uint64_t>(INT_MAX))
+        throw runtime_error("List file holds too many items!");
+}
+
+/* xlistWriteFile(path, items, itemSize, count): write header + items to "path"
+ */
+inline void xlistWriteFile(const string &path, const void *items, size_t itemSize, int count)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == 0)
+        throw runtime_error("Cannot open file for writing: " + path);
+    XListFileHeader header = xlistMakeHeader(itemSize, count);
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && count > 0)
+        ok = fwrite(items, itemSize, count, file) == static_cast<size_t>(count);
+    if (fclose(file) != 0)
+        ok = false;
+    if (!ok)
+        throw runtime_error("Cannot write file: " + path);
+}
+
+/* xlistOpenFile(path, itemSize, count): open "path" for reading, check its header and
+ *      leave the file positioned on the first item
+ */
+inline FILE *xlistOpenFile(const string &path, size_t itemSize, int &count)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == 0)
+        throw runtime_error("Cannot open file for reading: " + path);
+    XListFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1)
+    {
+        fclose(file);
+        throw runtime_error("List file is truncated: " + path);
+    }
+    try
+    {
+        xlistCheckHeader(header, itemSize);
+    }
+    catch (...)
+    {
+        fclose(file);
+        throw;
+    }
+    count = static_cast<int>(header.count);
+    return file;
+}
+
+/* xlistReadItems(file, path, items, itemSize, count): read the items that follow the header, then close "file"
+ */
+inline void xlistReadItems(FILE *file, const string &path, void *items, size_t itemSize, int count)
+{
+    bool ok = count == 0 || fread(items, itemSize, count, file) == static_cast<size_t>(count);
+    fclose(file);
+    if (!ok)
+        throw runtime_error("List file is truncated: " + path);
+}
+
+#ifdef XLIST_HAVE_MMAP
+/* xlistMapFile(path, itemSize, count): map "path" privately (copy-on-write: pages are read
+ *      on first touch, changes never reach the file); the items start sizeof(XListFileHeader)
+ *      bytes after the returned base
+ */
+inline XListMapping xlistMapFile(const string &path, size_t itemSize, int &count)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw runtime_error("Cannot open file for reading: " + path);
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(XListFileHeader))
+    {
+        close(fd);
+        throw runtime_error("List file is truncated: " + path);
+    }
+    XListMapping mapping;
+    mapping.length = static_cast<size_t>(info.st_size);
+    mapping.base = mmap(0, mapping.length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping.base == MAP_FAILED)
+        throw runtime_error("Cannot map file: " + path);
+
+    const XListFileHeader &header = *static_cast<const XListFileHeader *>(mapping.base);
+    try
+    {
+        xlistCheckHeader(header, itemSize);
+        if (mapping.length < sizeof(XListFileHeader) + header.count * itemSize)
+            throw runtime_error("List file is truncated: " + path);
+    }
+    catch (...)
+    {
+        munmap(mapping.base, mapping.length);
+        throw;
+    }
+    count = static_cast<int>(header.count);
+    return mapping;
+}
+
+inline void xlistUnmap(XListMapping &mapping)
+{
+    if (mapping.base != 0)
+        munmap(mapping.base, mapping.length);
+    mapping.base = 0;
+    mapping.length = 0;
+}
+#endif
+
+#endif /* LISTFILE_H */
@@ -0,0 +1,149 @@
+/*
+ * File:   ListFormat.h
+ *
+ * XListWriter: streams a list as "[a, b, c]" through one fixed-size buffer,
+ * so printing a list never builds the whole text in memory. Arithmetic items
+ * printed with the default formatter on a stream in its default state are
+ * converted with std::to_chars, which gives the same text as operator<<
+ * (precision 6, "%g" style for floating point) without going through the
+ * stream for every item.
+ */
+
+#ifndef LISTFORMAT_H
+#define LISTFORMAT_H
+#include "list/ListPolicy.h"
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <type_traits>
+using namespace std;
+
+// XLIST_WRITE_CHUNK: size of the buffer flushed to the stream
+static const int XLIST_WRITE_CHUNK = 4096;
+
+// XFastFormat<T>: T is written with std::to_chars (numbers, but not bool or characters)
+template <class T>
+struct XFastFormat
+{
+    static const bool value = std::is_arithmetic<T>::value &&
+                              !std::is_same<T, bool>::value &&
+                              !std::is_same<T, char>::value &&
+                              !std::is_same<T, signed char>::value &&
+                              !std::is_same<T, unsigned char>::value &&
+                              !std::is_same<T, wchar_t>::value &&
+                              !std::is_same<T, char16_t>::value &&
+                              !std::is_same<T, char32_t>::value;
+};
+
+template <class T, class Formatter = XFormatter<T>>
+class XListWriter
+{
+private:
+    ostream &os;
+    string (*item2str)(T &);
+    int maxItems; // -1: no limit
+    int written;
+    bool fastNumbers;
+    int used;
+    char buffer[XLIST_WRITE_CHUNK];
+
+public:
+    /* XListWriter(os, item2str, maxItems): start a list on "os"; items are written
+     *      with item2str if given, otherwise with Formatter; at most maxItems
+     *      items are written (-1: all), the rest is shown as "..."
+     */
+    XListWriter(ostream &os, string (*item2str)(T &) = 0, int maxItems = -1)
+        : os(os), item2str(item2str), maxItems(maxItems), written(0), used(0)
+    {
+        fastNumbers = XFastFormat<T>::value && item2str == 0 &&
+                      std::is_same<Formatter, XFormatter<T>>::value &&
+                      os.flags() == (ios_base::skipws | ios_base::dec) &&
+                      os.precision() == 6;
+        buffer[used++] = '[';
+    }
+    ~XListWriter()
+    {
+        flush();
+    }
+
+    // full(): true once maxItems items have been written
+    bool full()
+    {
+        return maxItems >= 0 && written >= maxItems;
+    }
+
+    void item(T &value)
+    {
+        if (written > 0)
+            put(", ", 2);
+        written++;
+        if constexpr (XFastFormat<T>::value)
+        {
+            if (fastNumbers)
+            {
+                if (used + 64 > XLIST_WRITE_CHUNK)
+                    flush();
+                std::to_chars_result result;
+                if constexpr (std::is_floating_point<T>::value)
+                    result = std::to_chars(buffer + used, buffer + XLIST_WRITE_CHUNK, value, std::chars_format::general, 6);
+                else
+                    result = std::to_chars(buffer + used, buffer + XLIST_WRITE_CHUNK, value);
+                used = static_cast<int>(result.ptr - buffer);
+                return;
+            }
+        }
+        if (item2str != 0)
+        {
+            string text = item2str(value);
+            put(text.data(), text.size());
+        }
+        else
+        {
+            flush();
+            Formatter format;
+            format(os, value);
+        }
+    }
+
+    // finish(total): close the list; "total" is the number of items in the list,
+    //      "..." marks the ones left out by maxItems
+    void finish(int total)
+    {
+        if (written < total)
+        {
+            if (written > 0)
+                put(", ", 2);
+            put("...", 3);
+        }
+        put("]", 1);
+        flush();
+    }
+
+    void flush()
+    {
+        if (used > 0)
+        {
+            os.write(buffer, used);
+            used = 0;
+        }
+    }
+
+private:
+    void put(const char *text, size_t n)
+    {
+        if (used + n > static_cast<size_t>(XLIST_WRITE_CHUNK))
+        {
+            flush();
+            if (n > static_cast<size_t>(XLIST_WRITE_CHUNK))
+            {
+                os.write(text, n);
+                return;
+            }
+        }
+        memcpy(buffer + used, text, n);
+        used += static_cast<int>(n);
+    }
+};
+
+#endif /* LISTFORMAT_H */
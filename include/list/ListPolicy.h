@@ -0,0 +1,83 @@
+/*
+ * File:   ListPolicy.h
+ *
+ * Compile-time policies shared by the list implementations.
+ */
+
+#ifndef LISTPOLICY_H
+#define LISTPOLICY_H
+#include <cstddef>
+#include <functional>
+#include <ostream>
+using namespace std;
+
+/* Growth policies for array-backed lists:
+ *   next(capacity) returns the capacity to try after "capacity" is full;
+ *   the list keeps calling it until the requested size fits.
+ */
+
+// XGrowDouble: capacity * 2 (default)
+struct XGrowDouble
+{
+    static int next(int capacity)
+    {
+        return capacity * 2;
+    }
+};
+
+// XGrowHalf: capacity * 1.5, less slack at the price of more reallocations
+struct XGrowHalf
+{
+    static int next(int capacity)
+    {
+        return capacity + capacity / 2 + 1;
+    }
+};
+
+// XGrowChunk<Chunk>: capacity + Chunk, for lists with a known, steady growth
+template <int Chunk>
+struct XGrowChunk
+{
+    static_assert(Chunk > 0, "XGrowChunk: Chunk must be positive");
+    static int next(int capacity)
+    {
+        return capacity + Chunk;
+    }
+};
+
+/* Item policies: plain function objects the compiler can inline into the
+ * list's scans. A list still accepts the classic function pointers
+ * (itemEqual, item2str); when one is given it takes precedence.
+ */
+
+// XEqual<T>: equality used by indexOf/contains/removeItem (default: operator==)
+template <class T>
+struct XEqual
+{
+    bool operator()(T &lhs, T &rhs) const
+    {
+        return lhs == rhs;
+    }
+};
+
+// XHash<T>: hash for hash-indexed lists, consistent with XEqual (default: std::hash)
+template <class T>
+struct XHash
+{
+    size_t operator()(const T &item) const
+    {
+        return std::hash<T>()(item);
+    }
+};
+
+// XFormatter<T>: writes one item for toString/println (default: operator<<)
+template <class T>
+struct XFormatter
+{
+    void operator()(ostream &os, T &item) const
+    {
+        os << item;
+    }
+};
+
+#endif /* LISTPOLICY_H */
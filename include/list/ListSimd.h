@@ -0,0 +1,276 @@
+/*
+ * File:   ListSimd.h
+ *
+ * Vectorized scan kernels over a contiguous buffer of int, float or double:
+ * find, count and min/max. The instruction set is chosen at compile time
+ * (AVX2 with -mavx2 or -march=native, SSE2 on any x86-64); other targets and
+ * other item types use the scalar loops, which are also the reference
+ * semantics: items are compared with operator== and operator<.
+ *
+ * min/max kernels fall back to the scalar loop when the buffer holds a NaN,
+ * so they return the same location as operator< would.
+ */
+
+#ifndef LISTSIMD_H
+#define LISTSIMD_H
+#include <type_traits>
+using namespace std;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// XSimdOps<T>: one register of T; "supported" tells whether the kernels below vectorize T
+template <class T>
+struct XSimdOps
+{
+    static const bool supported = false;
+};
+
+#if defined(__AVX2__)
+
+template <>
+struct XSimdOps<int>
+{
+    static const bool supported = true;
+    static const int width = 8;
+    typedef __m256i reg;
+    static reg load(const int *ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr)); }
+    static reg set1(int value) { return _mm256_set1_epi32(value); }
+    static int eqMask(reg a, reg b) { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))); }
+    static reg min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+    static void store(int *ptr, reg a) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(ptr), a); }
+    static reg noNan() { return _mm256_setzero_si256(); }
+    static reg markNan(reg marks, reg) { return marks; }
+    static bool anyNan(reg) { return false; }
+};
+
+template <>
+struct XSimdOps<float>
+{
+    static const bool supported = true;
+    static const int width = 8;
+    typedef __m256 reg;
+    static reg load(const float *ptr) { return _mm256_loadu_ps(ptr); }
+    static reg set1(float value) { return _mm256_set1_ps(value); }
+    static int eqMask(reg a, reg b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)); }
+    static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static void store(float *ptr, reg a) { _mm256_storeu_ps(ptr, a); }
+    // NaN lanes, accumulated over the scan
+    static reg noNan() { return _mm256_setzero_ps(); }
+    static reg markNan(reg marks, reg a) { return _mm256_or_ps(marks, _mm256_cmp_ps(a, a, _CMP_UNORD_Q)); }
+    static bool anyNan(reg marks) { return _mm256_movemask_ps(marks) != 0; }
+};
+
+template <>
+struct XSimdOps<double>
+{
+    static const bool supported = true;
+    static const int width = 4;
+    typedef __m256d reg;
+    static reg load(const double *ptr) { return _mm256_loadu_pd(ptr); }
+    static reg set1(double value) { return _mm256_set1_pd(value); }
+    static int eqMask(reg a, reg b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)); }
+    static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+    static void store(double *ptr, reg a) { _mm256_storeu_pd(ptr, a); }
+    static reg noNan() { return _mm256_setzero_pd(); }
+    static reg markNan(reg marks, reg a) { return _mm256_or_pd(marks, _mm256_cmp_pd(a, a, _CMP_UNORD_Q)); }
+    static bool anyNan(reg marks) { return _mm256_movemask_pd(marks) != 0; }
+};
+
+#elif defined(__SSE2__)
+
+template <>
+struct XSimdOps<int>
+{
+    static const bool supported = true;
+    static const int width = 4;
+    typedef __m128i reg;
+    static reg load(const int *ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr)); }
+    static reg set1(int value) { return _mm_set1_epi32(value); }
+    static int eqMask(reg a, reg b) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b))); }
+    // SSE2 has no 32-bit integer min/max: select through a compare mask
+    static reg min(reg a, reg b)
+    {
+        reg aGreater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(aGreater, b), _mm_andnot_si128(aGreater, a));
+    }
+    static reg max(reg a, reg b)
+    {
+        reg aGreater = _mm_cmpgt_epi32(a, b);
+        return _mm_or_si128(_mm_and_si128(aGreater, a), _mm_andnot_si128(aGreater, b));
+    }
+    static void store(int *ptr, reg a) { _mm_storeu_si128(reinterpret_cast<__m128i *>(ptr), a); }
+    static reg noNan() { return _mm_setzero_si128(); }
+    static reg markNan(reg marks, reg) { return marks; }
+    static bool anyNan(reg) { return false; }
+};
+
+template <>
+struct XSimdOps<float>
+{
+    static const bool supported = true;
+    static const int width = 4;
+    typedef __m128 reg;
+    static reg load(const float *ptr) { return _mm_loadu_ps(ptr); }
+    static reg set1(float value) { return _mm_set1_ps(value); }
+    static int eqMask(reg a, reg b) { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)); }
+    static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+    static void store(float *ptr, reg a) { _mm_storeu_ps(ptr, a); }
+    // NaN lanes, accumulated over the scan
+    static reg noNan() { return _mm_setzero_ps(); }
+    static reg markNan(reg marks, reg a) { return _mm_or_ps(marks, _mm_cmpunord_ps(a, a)); }
+    static bool anyNan(reg marks) { return _mm_movemask_ps(marks) != 0; }
+};
+
+template <>
+struct XSimdOps<double>
+{
+    static const bool supported = true;
+    static const int width = 2;
+    typedef __m128d reg;
+    static reg load(const double *ptr) { return _mm_loadu_pd(ptr); }
+    static reg set1(double value) { return _mm_set1_pd(value); }
+    static int eqMask(reg a, reg b) { return _mm_movemask_pd(_mm_cmpeq_pd(a, b)); }
+    static reg min(reg a, reg b) { return _mm_min_pd(a, b); }
+    static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+    static void store(double *ptr, reg a) { _mm_storeu_pd(ptr, a); }
+    static reg noNan() { return _mm_setzero_pd(); }
+    static reg markNan(reg marks, reg a) { return _mm_or_pd(marks, _mm_cmpunord_pd(a, a)); }
+    static bool anyNan(reg marks) { return _mm_movemask_pd(marks) != 0; }
+};
+
+#endif
+
+inline int xsimdFirstBit(int mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(static_cast<unsigned>(mask));
+#else
+    int bit = 0;
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+inline int xsimdBitCount(int mask)
+{
+#if defined(__GNUC__)
+    return __builtin_popcount(static_cast<unsigned>(mask));
+#else
+    int bits = 0;
+    for (; mask != 0; mask &= mask - 1)
+        bits++;
+    return bits;
+#endif
+}
+
+/* xsimdFind(ptr, n, value): location of the first item == value in [0, n), or -1
+ */
+template <class T>
+int xsimdFind(const T *ptr, int n, const T &value)
+{
+    int i = 0;
+    if constexpr (XSimdOps<T>::supported)
+    {
+        typedef XSimdOps<T> Ops;
+        typename Ops::reg needle = Ops::set1(value);
+        for (; i + Ops::width <= n; i += Ops::width)
+        {
+            int mask = Ops::eqMask(Ops::load(ptr + i), needle);
+            if (mask != 0)
+                return i + xsimdFirstBit(mask);
+        }
+    }
+    for (; i < n; i++)
+    {
+        if (ptr[i] == value)
+            return i;
+    }
+    return -1;
+}
+
+/* xsimdCount(ptr, n, value): number of items == value in [0, n)
+ */
+template <class T>
+int xsimdCount(const T *ptr, int n, const T &value)
+{
+    int i = 0, found = 0;
+    if constexpr (XSimdOps<T>::supported)
+    {
+        typedef XSimdOps<T> Ops;
+        typename Ops::reg needle = Ops::set1(value);
+        for (; i + Ops::width <= n; i += Ops::width)
+        {
+            found += xsimdBitCount(Ops::eqMask(Ops::load(ptr + i), needle));
+        }
+    }
+    for (; i < n; i++)
+    {
+        if (ptr[i] == value)
+            found++;
+    }
+    return found;
+}
+
+/* xsimdArgExtreme(ptr, n, wantMax): location of the first smallest (or largest) item by operator<, -1 if n == 0
+ */
+template <class T>
+int xsimdArgExtreme(const T *ptr, int n, bool wantMax)
+{
+    if (n <= 0)
+        return -1;
+    if constexpr (XSimdOps<T>::supported)
+    {
+        typedef XSimdOps<T> Ops;
+        if (n >= 2 * Ops::width)
+        {
+            // pass 1: the extreme value, one register at a time; pass 2: its first location.
+            // A NaN breaks both passes (min/max and == disagree with operator<): scalar loop
+            typename Ops::reg acc = Ops::load(ptr);
+            typename Ops::reg nans = Ops::markNan(Ops::noNan(), acc);
+            int i = Ops::width;
+            for (; i + Ops::width <= n; i += Ops::width)
+            {
+                typename Ops::reg item = Ops::load(ptr + i);
+                acc = wantMax ? Ops::max(acc, item) : Ops::min(acc, item);
+                nans = Ops::markNan(nans, item);
+            }
+            T lanes[Ops::width];
+            Ops::store(lanes, acc);
+            T best = lanes[0];
+            for (int lane = 1; lane < Ops::width; lane++)
+            {
+                if (wantMax ? best < lanes[lane] : lanes[lane] < best)
+                    best = lanes[lane];
+            }
+            bool hasNan = Ops::anyNan(nans);
+            for (; i < n && !hasNan; i++)
+            {
+                hasNan = !(ptr[i] == ptr[i]);
+                if (wantMax ? best < ptr[i] : ptr[i] < best)
+                    best = ptr[i];
+            }
+            int found = hasNan ? -1 : xsimdFind(ptr, n, best);
+            if (found >= 0)
+                return found;
+        }
+    }
+    int best = 0;
+    for (int i = 1; i < n; i++)
+    {
+        if (wantMax ? ptr[best] < ptr[i] : ptr[i] < ptr[best])
+            best = i;
+    }
+    return best;
+}
+
+#endif /* LISTSIMD_H */
@@ -0,0 +1,203 @@
+/*
+ * File:   ListSort.h
+ *
+ * Sorting kernels for contiguous ranges, shared by the lists.
+ * xsortBy sorts with std::sort (introsort) or std::stable_sort; a range of at
+ * least XSORT_PARALLEL_MIN items is cut into one chunk per hardware thread,
+ * the chunks are sorted concurrently, then neighbouring runs are merged
+ * pairwise (std::inplace_merge, which is stable), also concurrently, until a
+ * single run is left.
+ *
+ * NOTE: comparators must not throw while the parallel mode is running.
+ */
+
+#ifndef LISTSORT_H
+#define LISTSORT_H
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// XHasLess<T>: T can be ordered with operator<, the default order of sort()
+template <class T, class = void>
+struct XHasLess : std::false_type
+{
+};
+template <class T>
+struct XHasLess<T, std::void_t<decltype(std::declval<const T &>() < std::declval<const T &>())>> : std::true_type
+{
+};
+
+// XSORT_PARALLEL_MIN: smallest range sorted by several threads
+static const int XSORT_PARALLEL_MIN = 1 << 17;
+
+template <class T, class Compare>
+void xsortChunk(T *first, T *last, Compare less, bool stable)
+{
+    if (stable)
+        std::stable_sort(first, last, less);
+    else
+        std::sort(first, last, less);
+}
+
+/* xsortParallel(first, last, less, stable, threads): sort [first, last) as "threads" chunks
+ *      sorted concurrently, then merged pairwise
+ */
+template <class T, class Compare>
+void xsortParallel(T *first, T *last, Compare less, bool stable, int threads)
+{
+    ptrdiff_t n = last - first;
+    if (threads > n)
+        threads = static_cast<int>(n);
+    if (threads < 2)
+    {
+        xsortChunk(first, last, less, stable);
+        return;
+    }
+
+    vector<T *> bounds(threads + 1);
+    for (int chunk = 0; chunk <= threads; chunk++)
+        bounds[chunk] = first + n * chunk / threads;
+
+    vector<std::thread> workers;
+    for (int chunk = 0; chunk < threads; chunk++)
+    {
+        T *lo = bounds[chunk], *hi = bounds[chunk + 1];
+        workers.emplace_back([lo, hi, less, stable]()
+                             { xsortChunk(lo, hi, less, stable); });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+
+    // merge rounds: runs of "width" chunks are merged with their right neighbour
+    for (int width = 1; width < threads; width *= 2)
+    {
+        workers.clear();
+        for (int chunk = 0; chunk + width < threads; chunk += 2 * width)
+        {
+            int end = chunk + 2 * width < threads ? chunk + 2 * width : threads;
+            T *lo = bounds[chunk], *mid = bounds[chunk + width], *hi = bounds[end];
+            workers.emplace_back([lo, mid, hi, less]()
+                                 { std::inplace_merge(lo, mid, hi, less); });
+        }
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+}
+
+/* xsortBy(first, last, less, stable): sort [first, last) by "less" (a strict weak ordering);
+ *      stable=true keeps equal items in their original order
+ */
+template <class T, class Compare>
+void xsortBy(T *first, T *last, Compare less, bool stable)
+{
+    ptrdiff_t n = last - first;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (n < XSORT_PARALLEL_MIN || threads < 2)
+    {
+        xsortChunk(first, last, less, stable);
+        return;
+    }
+    // no chunk below a quarter of XSORT_PARALLEL_MIN items
+    if (threads > n / (XSORT_PARALLEL_MIN / 4))
+        threads = static_cast<int>(n / (XSORT_PARALLEL_MIN / 4));
+    xsortParallel(first, last, less, stable, threads);
+}
+
+/* XSortBuffer<T>: raw array the items are moved into to be sorted (std::vector<bool>
+ *      has no data(), so the fallbacks cannot use std::vector); grows if pushed past capacity
+ */
+template <class T>
+class XSortBuffer
+{
+private:
+    std::allocator<T> alloc;
+    T *items;
+    int count;
+    int capacity;
+
+public:
+    XSortBuffer(int capacity)
+    {
+        this->capacity = capacity > 0 ? capacity : 1;
+        this->count = 0;
+        this->items = alloc.allocate(this->capacity);
+    }
+    ~XSortBuffer()
+    {
+        for (int i = 0; i < count; i++)
+            items[i].~T();
+        alloc.deallocate(items, capacity);
+    }
+    void push(T &&item)
+    {
+        if (count == capacity)
+            grow();
+        new (items + count) T(std::move(item));
+        count++;
+    }
+    T *begin()
+    {
+        return items;
+    }
+    T *end()
+    {
+        return items + count;
+    }
+    T &operator[](int index)
+    {
+        return items[index];
+    }
+
+private:
+    void grow()
+    {
+        T *bigger = alloc.allocate(capacity * 2);
+        for (int i = 0; i < count; i++)
+        {
+            new (bigger + i) T(std::move(items[i]));
+            items[i].~T();
+        }
+        alloc.deallocate(items, capacity);
+        items = bigger;
+        capacity *= 2;
+    }
+};
+
+/* xsortCheck(comparator): throw std::invalid_argument if comparator is 0 and T has no operator<
+ */
+template <class T>
+void xsortCheck(bool (*comparator)(T &, T &))
+{
+    if (comparator == 0 && !XHasLess<T>::value)
+        throw std::invalid_argument("Items have no operator<, a comparator is required!");
+}
+
+/* xsortRange(first, last, comparator, stable): xsortBy with the comparator of IList::sort;
+ *      comparator 0 means operator<, and throws std::invalid_argument if T has none
+ */
+template <class T>
+void xsortRange(T *first, T *last, bool (*comparator)(T &, T &), bool stable)
+{
+    xsortCheck(comparator);
+    if (comparator != 0)
+    {
+        // the standard algorithms hand out const references; comparators take T& like itemEqual
+        xsortBy(first, last, [comparator](const T &lhs, const T &rhs)
+                { return comparator(const_cast<T &>(lhs), const_cast<T &>(rhs)); }, stable);
+    }
+    else
+    {
+        if constexpr (XHasLess<T>::value)
+            xsortBy(first, last, [](const T &lhs, const T &rhs)
+                    { return lhs < rhs; }, stable);
+    }
+}
+
+#endif /* LISTSORT_H */
@@ -0,0 +1,216 @@
+/*
+ * File:   ListStats.h
+ *
+ * Opt-in instrumentation of XArrayList and DLinkedList: compile with
+ * -DXLIST_INSTRUMENT and every list type counts its allocations, bytes,
+ * reallocations, item copies/moves, the walk lengths of get/removeAt and the
+ * items scanned by indexOf. Counters are kept per list type (all
+ * XArrayList<int> share one set) in a registry that is printed to stderr at
+ * exit: as a table by default, as JSON with XLIST_STATS=json, not at all with
+ * XLIST_STATS=off. XListStatsRegistry::instance().dumpTable/dumpJson print it
+ * on demand.
+ *
+ * Without XLIST_INSTRUMENT, XLIST_STAT expands to nothing: the lists compile
+ * exactly as if the counters did not exist.
+ */
+
+#ifndef LISTSTATS_H
+#define LISTSTATS_H
+
+#ifdef XLIST_INSTRUMENT
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+using namespace std;
+
+struct XListStats
+{
+    std::atomic<long long> allocations;    // buffers (arrays) or nodes (linked lists) allocated
+    std::atomic<long long> bytes;          // bytes allocated
+    std::atomic<long long> frees;          // buffers or nodes given back
+    std::atomic<long long> reallocations;  // arrays moved to a buffer of another size
+    std::atomic<long long> copies;         // items copied
+    std::atomic<long long> moves;          // items moved (appended, shifted, relocated)
+    std::atomic<long long> gets;           // get() calls
+    std::atomic<long long> getSteps;       // nodes walked by get() (arrays: 0)
+    std::atomic<long long> removes;        // removeAt() calls
+    std::atomic<long long> removeSteps;    // nodes walked by removeAt() (arrays: items shifted)
+    std::atomic<long long> indexOfs;       // indexOf() calls
+    std::atomic<long long> indexOfScanned; // items compared by indexOf()
+
+    XListStats() { reset(); }
+    void reset()
+    {
+        for (std::atomic<long long> *counter : counters())
+            counter->store(0, std::memory_order_relaxed);
+    }
+    vector<std::atomic<long long> *> counters()
+    {
+        return {&allocations, &bytes, &frees, &reallocations, &copies, &moves,
+                &gets, &getSteps, &removes, &removeSteps, &indexOfs, &indexOfScanned};
+    }
+    static vector<const char *> names()
+    {
+        return {"allocations", "bytes", "frees", "reallocations", "copies", "moves",
+                "gets", "getSteps", "removes", "removeSteps", "indexOfs", "indexOfScanned"};
+    }
+};
+
+/* XListStatsRegistry: the counters of every instrumented list type, in order of first use.
+ * The registry and its counters are never destroyed, so lists in static storage can still
+ * count while the program exits.
+ */
+class XListStatsRegistry
+{
+private:
+    std::mutex lock;
+    vector<pair<string, XListStats *>> entries;
+
+    XListStatsRegistry() {}
+    static void dumpAtExit()
+    {
+        const char *format = getenv("XLIST_STATS");
+        if (format != 0 && strcmp(format, "off") == 0)
+            return;
+        if (format != 0 && strcmp(format, "json") == 0)
+            instance().dumpJson(cerr);
+        else
+            instance().dumpTable(cerr);
+    }
+
+public:
+    static XListStatsRegistry &instance()
+    {
+        static XListStatsRegistry *registry = []
+        {
+            XListStatsRegistry *created = new XListStatsRegistry();
+            atexit(dumpAtExit);
+            return created;
+        }();
+        return *registry;
+    }
+
+    // add(name): new counters for the list type "name"
+    XListStats *add(const string &name)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        XListStats *stats = new XListStats();
+        entries.push_back(make_pair(name, stats));
+        return stats;
+    }
+    void reset()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto &entry : entries)
+            entry.second->reset();
+    }
+
+    // dumpTable(os): every counter of every list type, plus the average walk and scan lengths
+    void dumpTable(ostream &os)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        vector<const char *> names = XListStats::names();
+        os << "XList stats" << endl;
+        for (auto &entry : entries)
+        {
+            XListStats &stats = *entry.second;
+            os << "  " << entry.first << endl;
+            vector<std::atomic<long long> *> counters = stats.counters();
+            for (size_t i = 0; i < counters.size(); i++)
+            {
+                char line[64];
+                snprintf(line, sizeof(line), "    %-16s %16lld", names[i], counters[i]->load());
+                os << line << endl;
+            }
+            char line[128];
+            snprintf(line, sizeof(line), "    %-16s %16.2f\n    %-16s %16.2f\n    %-16s %16.2f",
+                     "avg get walk", average(stats.getSteps, stats.gets),
+                     "avg remove walk", average(stats.removeSteps, stats.removes),
+                     "avg indexOf scan", average(stats.indexOfScanned, stats.indexOfs));
+            os << line << endl;
+        }
+    }
+
+    // dumpJson(os): {"<list type>": {"<counter>": value, ...}, ...}
+    void dumpJson(ostream &os)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        vector<const char *> names = XListStats::names();
+        os << "{";
+        for (size_t e = 0; e < entries.size(); e++)
+        {
+            XListStats &stats = *entries[e].second;
+            os << (e == 0 ? "\n" : ",\n") << "  \"" << entries[e].first << "\": {";
+            vector<std::atomic<long long> *> counters = stats.counters();
+            for (size_t i = 0; i < counters.size(); i++)
+                os << (i == 0 ? "" : ", ") << "\"" << names[i] << "\": " << counters[i]->load();
+            os << ", \"avgGetWalk\": " << average(stats.getSteps, stats.gets)
+               << ", \"avgRemoveWalk\": " << average(stats.removeSteps, stats.removes)
+               << ", \"avgIndexOfScan\": " << average(stats.indexOfScanned, stats.indexOfs) << "}";
+        }
+        os << "\n}" << endl;
+    }
+
+private:
+    static double average(std::atomic<long long> &total, std::atomic<long long> &calls)
+    {
+        long long n = calls.load();
+        return n == 0 ? 0.0 : static_cast<double>(total.load()) / n;
+    }
+};
+
+// xlistTypeName<List>(): readable name of a list type
+template <class List>
+string xlistTypeName()
+{
+    const char *name = typeid(List).name();
+#ifdef __GNUG__
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name, 0, 0, &status);
+    if (status == 0 && demangled != 0)
+    {
+        string result(demangled);
+        std::free(demangled);
+        return result;
+    }
+#endif
+    return name;
+}
+
+// xlistStats<List>(): the counters of the list type "List"
+template <class List>
+XListStats &xlistStats()
+{
+    static XListStats *stats = XListStatsRegistry::instance().add(xlistTypeName<List>());
+    return *stats;
+}
+
+// xlistItemCopied<Args...>(): true when an item built from "Args" is a copy (an lvalue item), false for a move
+template <class... Args>
+constexpr bool xlistItemCopied()
+{
+    if constexpr (sizeof...(Args) == 0)
+        return false;
+    else
+        return std::is_lvalue_reference<typename std::tuple_element<0, std::tuple<Args...>>::type>::value;
+}
+
+// XLIST_STAT(List, counter, n): add n to "counter" of the list type "List"
+#define XLIST_STAT(List, counter, n) (xlistStats<List>().counter.fetch_add((n), std::memory_order_relaxed))
+#else
+#define XLIST_STAT(List, counter, n) ((void)0)
+#endif
+
+#endif /* LISTSTATS_H */
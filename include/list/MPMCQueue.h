@@ -0,0 +1,555 @@
+/*
+ * File:   MPMCQueue.h
+ *
+ * Lock-free queues for handing items between threads (any number of
+ * producers and consumers):
+ *
+ *  XRingQueue<T>   bounded ring (D. Vyukov's MPMC queue): every slot carries a
+ *                  sequence number that tells producers and consumers whose
+ *                  turn it is, so a push or pop is one CAS on a shared counter.
+ *  XLinkedQueue<T> unbounded Michael-Scott queue: a singly linked chain of
+ *                  nodes (item + next, like DLinkedList::Node without "prev")
+ *                  behind a dummy head node. Removed nodes are freed through
+ *                  hazard pointers, so a thread never frees a node another
+ *                  thread is still reading.
+ *
+ * Both offer tryPush/tryPop for single items and pushBatch/popBatch, which
+ * move several items with one synchronization step where the structure
+ * allows it.
+ */
+
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// XQUEUE_LINE: cache line size, to keep the producer and consumer counters apart
+static const int XQUEUE_LINE = 64;
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     XRingQueue        ///////////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+class XRingQueue
+{
+protected:
+    // Cell: "sequence" == position: free for the producer of that position;
+    //      == position + 1: holds the item for the consumer of that position
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+        T *item()
+        {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+    };
+
+    Cell *cells;
+    size_t mask; // number of cells - 1 (a power of 2 minus 1)
+    alignas(XQUEUE_LINE) std::atomic<size_t> pushPos;
+    alignas(XQUEUE_LINE) std::atomic<size_t> popPos;
+
+public:
+    // XRingQueue(capacity): room for at least "capacity" items (rounded up to a power of 2)
+    XRingQueue(int capacity = 1024);
+    XRingQueue(const XRingQueue<T> &queue) = delete;
+    XRingQueue<T> &operator=(const XRingQueue<T> &queue) = delete;
+    ~XRingQueue();
+
+    // tryPush(e): add "e" at the back; false (and "e" untouched) if the queue is full
+    bool tryPush(const T &e);
+    bool tryPush(T &&e);
+    // tryPop(out): move the front item into "out"; false if the queue is empty
+    bool tryPop(T &out);
+    // pushBatch(items, n): push the first k <= n items with one claim; returns k (0: full)
+    int pushBatch(const T *items, int n);
+    // popBatch(out, n): pop up to n items into "out" with one claim; returns how many
+    int popBatch(T *out, int n);
+
+    int capacity()
+    {
+        return static_cast<int>(mask + 1);
+    }
+    // size(): number of items; only a snapshot while other threads are running
+    int size();
+    bool empty()
+    {
+        return size() == 0;
+    }
+
+protected:
+    template <class U>
+    bool pushOne(U &&e);
+};
+
+template <class T>
+XRingQueue<T>::XRingQueue(int capacity)
+{
+    size_t cellCount = 2;
+    while (cellCount < static_cast<size_t>(capacity))
+        cellCount *= 2;
+    mask = cellCount - 1;
+    cells = new Cell[cellCount];
+    for (size_t i = 0; i < cellCount; i++)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    pushPos.store(0, std::memory_order_relaxed);
+    popPos.store(0, std::memory_order_relaxed);
+}
+
+template <class T>
+XRingQueue<T>::~XRingQueue()
+{
+    size_t last = pushPos.load(std::memory_order_relaxed);
+    for (size_t pos = popPos.load(std::memory_order_relaxed); pos != last; pos++)
+        cells[pos & mask].item()->~T();
+    delete[] cells;
+}
+
+template <class T>
+bool XRingQueue<T>::tryPush(const T &e)
+{
+    return pushOne(e);
+}
+
+template <class T>
+bool XRingQueue<T>::tryPush(T &&e)
+{
+    return pushOne(std::move(e));
+}
+
+template <class T>
+template <class U>
+bool XRingQueue<T>::pushOne(U &&e)
+{
+    size_t pos = pushPos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Cell &cell = cells[pos & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        ptrdiff_t diff = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos);
+        if (diff == 0)
+        {
+            if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                new (cell.storage) T(std::forward<U>(e));
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false; // the cell still holds the item of the previous round
+        }
+        else
+        {
+            pos = pushPos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <class T>
+bool XRingQueue<T>::tryPop(T &out)
+{
+    return popBatch(&out, 1) == 1;
+}
+
+template <class T>
+int XRingQueue<T>::pushBatch(const T *items, int n)
+{
+    if (n <= 0)
+        return 0;
+    size_t pos = pushPos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        // count the free cells from "pos" on; they stay free until their position is claimed
+        int k = 0;
+        while (k < n && k <= static_cast<int>(mask))
+        {
+            size_t sequence = cells[(pos + k) & mask].sequence.load(std::memory_order_acquire);
+            if (sequence != pos + k)
+                break;
+            k++;
+        }
+        if (k == 0)
+        {
+            size_t sequence = cells[pos & mask].sequence.load(std::memory_order_acquire);
+            if (static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos) < 0)
+                return 0; // full
+            pos = pushPos.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (pushPos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+        {
+            for (int i = 0; i < k; i++)
+            {
+                Cell &cell = cells[(pos + i) & mask];
+                new (cell.storage) T(items[i]);
+                cell.sequence.store(pos + i + 1, std::memory_order_release);
+            }
+            return k;
+        }
+    }
+}
+
+template <class T>
+int XRingQueue<T>::popBatch(T *out, int n)
+{
+    if (n <= 0)
+        return 0;
+    size_t pos = popPos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        // count the filled cells from "pos" on
+        int k = 0;
+        while (k < n && k <= static_cast<int>(mask))
+        {
+            size_t sequence = cells[(pos + k) & mask].sequence.load(std::memory_order_acquire);
+            if (sequence != pos + k + 1)
+                break;
+            k++;
+        }
+        if (k == 0)
+        {
+            size_t sequence = cells[pos & mask].sequence.load(std::memory_order_acquire);
+            if (static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos + 1) < 0)
+                return 0; // empty
+            pos = popPos.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (popPos.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+        {
+            for (int i = 0; i < k; i++)
+            {
+                Cell &cell = cells[(pos + i) & mask];
+                out[i] = std::move(*cell.item());
+                cell.item()->~T();
+                cell.sequence.store(pos + i + mask + 1, std::memory_order_release);
+            }
+            return k;
+        }
+    }
+}
+
+template <class T>
+int XRingQueue<T>::size()
+{
+    size_t pushed = pushPos.load(std::memory_order_relaxed);
+    size_t popped = popPos.load(std::memory_order_relaxed);
+    return pushed > popped ? static_cast<int>(pushed - popped) : 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     XLinkedQueue      ///////////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+class XLinkedQueue
+{
+public:
+    class Node; // Forward declaration
+
+protected:
+    // HazardRecord: owned by one operation at a time; "hazard" are the nodes it is
+    //      reading, "retired" the nodes it removed that may still be read by others
+    struct HazardRecord
+    {
+        std::atomic<bool> active;
+        std::atomic<Node *> hazard[2];
+        vector<Node *> retired;
+    };
+    static const int RECORDS = 128;
+    static const int RETIRE_SCAN = 2 * 2 * RECORDS; // retired nodes before a reclamation pass
+
+    alignas(XQUEUE_LINE) std::atomic<Node *> head; // dummy node; the items start at head->next
+    alignas(XQUEUE_LINE) std::atomic<Node *> tail;
+    HazardRecord *records;
+
+public:
+    XLinkedQueue();
+    XLinkedQueue(const XLinkedQueue<T> &queue) = delete;
+    XLinkedQueue<T> &operator=(const XLinkedQueue<T> &queue) = delete;
+    ~XLinkedQueue();
+
+    // tryPush(e): add "e" at the back; always succeeds (the queue is unbounded)
+    bool tryPush(const T &e);
+    bool tryPush(T &&e);
+    // tryPop(out): move the front item into "out"; false if the queue is empty
+    bool tryPop(T &out);
+    // pushBatch(items, n): link the n items as one chain with a single CAS; returns n
+    int pushBatch(const T *items, int n);
+    // popBatch(out, n): pop up to n items into "out"; returns how many
+    int popBatch(T *out, int n);
+    // empty(): only a snapshot while other threads are running
+    bool empty()
+    {
+        return head.load()->next.load() == 0;
+    }
+
+protected:
+    HazardRecord *acquireRecord();
+    void releaseRecord(HazardRecord *record)
+    {
+        record->hazard[0].store(0);
+        record->hazard[1].store(0);
+        record->active.store(false, std::memory_order_release);
+    }
+    // linkChain: append the chain [first, last] (already linked through "next")
+    void linkChain(Node *first, Node *last);
+    bool popWith(HazardRecord *record, T &out);
+    void retire(HazardRecord *record, Node *node);
+    // reclaim: free the retired nodes of "record" that no operation is reading
+    void reclaim(HazardRecord *record);
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    class Node
+    {
+    public:
+        std::atomic<Node *> next;
+        friend class XLinkedQueue<T>;
+
+    private:
+        // the item is constructed in push and destroyed by the pop that takes it,
+        // so the dummy node never holds one
+        alignas(T) unsigned char storage[sizeof(T)];
+
+    public:
+        Node() : next(0) {}
+        template <class U>
+        explicit Node(U &&e, int) : next(0)
+        {
+            new (storage) T(std::forward<U>(e));
+        }
+        T *item()
+        {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+    };
+};
+
+template <class T>
+XLinkedQueue<T>::XLinkedQueue()
+{
+    Node *dummy = new Node();
+    head.store(dummy);
+    tail.store(dummy);
+    records = new HazardRecord[RECORDS];
+    for (int i = 0; i < RECORDS; i++)
+    {
+        records[i].active.store(false);
+        records[i].hazard[0].store(0);
+        records[i].hazard[1].store(0);
+    }
+}
+
+template <class T>
+XLinkedQueue<T>::~XLinkedQueue()
+{
+    Node *node = head.load();
+    Node *next = node->next.load();
+    delete node; // the dummy holds no item
+    for (node = next; node != 0; node = next)
+    {
+        next = node->next.load();
+        node->item()->~T();
+        delete node;
+    }
+    for (int i = 0; i < RECORDS; i++)
+    {
+        for (Node *retired : records[i].retired)
+            delete retired;
+    }
+    delete[] records;
+}
+
+template <class T>
+bool XLinkedQueue<T>::tryPush(const T &e)
+{
+    Node *node = new Node(e, 0);
+    linkChain(node, node);
+    return true;
+}
+
+template <class T>
+bool XLinkedQueue<T>::tryPush(T &&e)
+{
+    Node *node = new Node(std::move(e), 0);
+    linkChain(node, node);
+    return true;
+}
+
+template <class T>
+int XLinkedQueue<T>::pushBatch(const T *items, int n)
+{
+    if (n <= 0)
+        return 0;
+    Node *first = new Node(items[0], 0);
+    Node *last = first;
+    for (int i = 1; i < n; i++)
+    {
+        Node *node = new Node(items[i], 0);
+        last->next.store(node, std::memory_order_relaxed);
+        last = node;
+    }
+    linkChain(first, last);
+    return n;
+}
+
+template <class T>
+bool XLinkedQueue<T>::tryPop(T &out)
+{
+    HazardRecord *record = acquireRecord();
+    bool popped = popWith(record, out);
+    releaseRecord(record);
+    return popped;
+}
+
+template <class T>
+int XLinkedQueue<T>::popBatch(T *out, int n)
+{
+    HazardRecord *record = acquireRecord();
+    int popped = 0;
+    while (popped < n && popWith(record, out[popped]))
+        popped++;
+    releaseRecord(record);
+    return popped;
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+typename XLinkedQueue<T>::HazardRecord *XLinkedQueue<T>::acquireRecord()
+{
+    // start at a slot picked by the thread id, so threads rarely collide
+    size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+    while (true)
+    {
+        for (int i = 0; i < RECORDS; i++)
+        {
+            HazardRecord &record = records[(start + i) % RECORDS];
+            bool expected = false;
+            if (!record.active.load(std::memory_order_relaxed) &&
+                record.active.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return &record;
+        }
+        std::this_thread::yield();
+    }
+}
+
+template <class T>
+void XLinkedQueue<T>::linkChain(Node *first, Node *last)
+{
+    // the node read from "tail" may be popped and retired meanwhile: guard it with a hazard pointer
+    HazardRecord *record = acquireRecord();
+    while (true)
+    {
+        Node *lastNode = tail.load();
+        record->hazard[0].store(lastNode);
+        if (tail.load() != lastNode)
+            continue;
+        Node *next = lastNode->next.load();
+        if (tail.load() != lastNode)
+            continue;
+        if (next != 0)
+        {
+            tail.compare_exchange_strong(lastNode, next); // help a lagging tail
+            continue;
+        }
+        Node *expected = 0;
+        if (lastNode->next.compare_exchange_strong(expected, first))
+        {
+            tail.compare_exchange_strong(lastNode, last);
+            break;
+        }
+    }
+    releaseRecord(record);
+}
+
+template <class T>
+bool XLinkedQueue<T>::popWith(HazardRecord *record, T &out)
+{
+    while (true)
+    {
+        Node *first = head.load();
+        record->hazard[0].store(first);
+        if (head.load() != first)
+            continue;
+        Node *lastNode = tail.load();
+        Node *next = first->next.load();
+        record->hazard[1].store(next);
+        if (head.load() != first)
+            continue;
+        if (next == 0)
+        {
+            record->hazard[0].store(0);
+            record->hazard[1].store(0);
+            return false;
+        }
+        if (first == lastNode)
+        {
+            tail.compare_exchange_strong(lastNode, next); // help a lagging tail
+            continue;
+        }
+        if (head.compare_exchange_strong(first, next))
+        {
+            // "next" is the new dummy: only this thread may take its item
+            out = std::move(*next->item());
+            next->item()->~T();
+            record->hazard[0].store(0);
+            record->hazard[1].store(0);
+            retire(record, first);
+            return true;
+        }
+    }
+}
+
+template <class T>
+void XLinkedQueue<T>::retire(HazardRecord *record, Node *node)
+{
+    record->retired.push_back(node);
+    if (static_cast<int>(record->retired.size()) >= RETIRE_SCAN)
+        reclaim(record);
+}
+
+template <class T>
+void XLinkedQueue<T>::reclaim(HazardRecord *record)
+{
+    vector<Node *> hazards;
+    hazards.reserve(2 * RECORDS);
+    for (int i = 0; i < RECORDS; i++)
+    {
+        for (int h = 0; h < 2; h++)
+        {
+            Node *node = records[i].hazard[h].load();
+            if (node != 0)
+                hazards.push_back(node);
+        }
+    }
+    std::sort(hazards.begin(), hazards.end());
+    vector<Node *> kept;
+    for (Node *node : record->retired)
+    {
+        if (std::binary_search(hazards.begin(), hazards.end(), node))
+            kept.push_back(node);
+        else
+            delete node;
+    }
+    record->retired.swap(kept);
+}
+
+#endif /* MPMCQUEUE_H */
@@ -0,0 +1,166 @@
+/*
+ * File:   NodePool.h
+ *
+ * Node allocators for the linked lists. A pool hands out raw, fixed-size
+ * blocks; the list constructs/destroys its nodes inside them.
+ */
+
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+#include <cstddef>
+#include <new>
+using namespace std;
+
+// raw block allocation; the aligned overloads are only used for over-aligned nodes
+inline void *xpoolAllocate(size_t bytes, size_t align)
+{
+    if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        return ::operator new(bytes, std::align_val_t(align));
+    return ::operator new(bytes);
+}
+inline void xpoolRelease(void *ptr, size_t align)
+{
+    if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        ::operator delete(ptr, std::align_val_t(align));
+    else
+        ::operator delete(ptr);
+}
+
+/* XSlabNodePool: carves nodes out of large slabs and recycles released nodes
+ *      through a free list, so steady add/remove traffic never reaches the global
+ *      allocator. releaseAll() returns every slab at once.
+ */
+class XSlabNodePool
+{
+public:
+    static const bool bulkRelease = true; // releaseAll() frees every node handed out
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+    struct Slab
+    {
+        Slab *next;
+    };
+
+    size_t blockSize;   // node size, rounded up to the alignment
+    size_t align;       // alignment of every block
+    size_t headerSize;  // bytes in front of the first block of a slab
+    int slabNodes;      // number of blocks in the next slab
+    int firstSlabNodes; // blocks in the first slab, again after releaseAll()
+    int maxSlabNodes;   // slabs grow geometrically up to this many blocks
+    Slab *slabs;        // all slabs, most recent first
+    char *cursor;       // next never-used block of the current slab
+    char *slabEnd;      // end of the current slab
+    FreeBlock *freeList;
+
+public:
+    XSlabNodePool(size_t nodeSize, size_t nodeAlign = alignof(max_align_t),
+                  int firstSlabNodes = 32, int maxSlabNodes = 4096)
+    {
+        align = nodeAlign < alignof(FreeBlock) ? alignof(FreeBlock) : nodeAlign;
+        blockSize = roundUp(nodeSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : nodeSize, align);
+        headerSize = roundUp(sizeof(Slab), align);
+        this->slabNodes = firstSlabNodes;
+        this->firstSlabNodes = firstSlabNodes;
+        this->maxSlabNodes = maxSlabNodes;
+        slabs = 0;
+        cursor = slabEnd = 0;
+        freeList = 0;
+    }
+    XSlabNodePool(const XSlabNodePool &) = delete;
+    XSlabNodePool &operator=(const XSlabNodePool &) = delete;
+    ~XSlabNodePool()
+    {
+        releaseAll();
+    }
+
+    void *allocate()
+    {
+        if (freeList != 0)
+        {
+            FreeBlock *block = freeList;
+            freeList = block->next;
+            return block;
+        }
+        if (cursor == slabEnd)
+        {
+            newSlab();
+        }
+        void *block = cursor;
+        cursor += blockSize;
+        return block;
+    }
+    void release(void *node)
+    {
+        FreeBlock *block = static_cast<FreeBlock *>(node);
+        block->next = freeList;
+        freeList = block;
+    }
+    void releaseAll()
+    {
+        while (slabs != 0)
+        {
+            Slab *next = slabs->next;
+            xpoolRelease(slabs, align);
+            slabs = next;
+        }
+        cursor = slabEnd = 0;
+        freeList = 0;
+        slabNodes = firstSlabNodes; // a cleared list that is reused for a few items starts small again
+    }
+
+private:
+    static size_t roundUp(size_t size, size_t align)
+    {
+        return (size + align - 1) / align * align;
+    }
+    void newSlab()
+    {
+        size_t bytes = headerSize + blockSize * slabNodes;
+        Slab *slab = static_cast<Slab *>(xpoolAllocate(bytes, align));
+        slab->next = slabs;
+        slabs = slab;
+        cursor = reinterpret_cast<char *>(slab) + headerSize;
+        slabEnd = reinterpret_cast<char *>(slab) + bytes;
+        if (slabNodes < maxSlabNodes)
+        {
+            slabNodes = slabNodes * 2 < maxSlabNodes ? slabNodes * 2 : maxSlabNodes;
+        }
+    }
+};
+
+/* XHeapNodePool: one global-allocator call per node (the classic behaviour);
+ *      use it for lists whose nodes must be returned to the system one by one.
+ */
+class XHeapNodePool
+{
+public:
+    static const bool bulkRelease = false;
+
+private:
+    size_t nodeSize;
+    size_t align;
+
+public:
+    XHeapNodePool(size_t nodeSize, size_t nodeAlign = alignof(max_align_t))
+    {
+        this->nodeSize = nodeSize;
+        this->align = nodeAlign;
+    }
+    void *allocate()
+    {
+        return xpoolAllocate(nodeSize, align);
+    }
+    void release(void *node)
+    {
+        xpoolRelease(node, align);
+    }
+    void releaseAll()
+    {
+    }
+};
+
+#endif /* NODEPOOL_H */
@@ -0,0 +1,632 @@
+/*
+ * File:   PersistentList.h
+ *
+ * PersistentList<T>: an immutable list (a 32-way trie, as in Clojure's
+ * persistent vector). A version never changes: push_back, set and pop_back
+ * return a new version in O(log32 n) that shares every untouched node with
+ * the old one. Copying a version is O(1) (nodes are reference counted), so
+ * snapshots cost almost no time or memory.
+ *
+ * Layout: the last 1..32 items live in "tail"; the others are in full leaves
+ * of 32 items under "root", "shift" / 5 levels deep.
+ *
+ * As an IList it is read-only: get/indexOf/contains/toString work; add,
+ * removeAt, clear, ... throw std::logic_error.
+ * NOTE: items returned by get(index) are shared between versions and must
+ * not be modified; use set(index, e) instead.
+ */
+
+#ifndef PERSISTENTLIST_H
+#define PERSISTENTLIST_H
+#include "list/IList.h"
+#include "list/ListFormat.h"
+#include <atomic>
+#include <new>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+using namespace std;
+
+template <class T>
+class PersistentList : public IList<T>
+{
+protected:
+    static const int BITS = 5;
+    static const int WIDTH = 1 << BITS; // children per branch, items per leaf
+    static const int MASK = WIDTH - 1;
+
+    struct Node
+    {
+        std::atomic<int> refs;
+        bool leaf;
+        Node(bool leaf) : refs(1), leaf(leaf) {}
+    };
+    struct Branch : Node
+    {
+        Node *children[WIDTH];
+        Branch() : Node(false)
+        {
+            for (int i = 0; i < WIDTH; i++)
+                children[i] = 0;
+        }
+    };
+    struct Leaf : Node
+    {
+        int size; // items constructed in [0, size)
+        alignas(T) unsigned char storage[WIDTH * sizeof(T)];
+        Leaf() : Node(true), size(0) {}
+        ~Leaf()
+        {
+            for (int i = 0; i < size; i++)
+                items()[i].~T();
+        }
+        T *items()
+        {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+        void append(const T &item)
+        {
+            new (storage + size * sizeof(T)) T(item);
+            size++;
+        }
+    };
+
+    int count;
+    int shift; // level of root: leaves are reached after shift / BITS steps
+    Branch *root;
+    Leaf *tail;
+    bool (*itemEqual)(T &lhs, T &rhs); // function pointer: test if two items (type: T&) are equal or not
+
+public:
+    PersistentList(bool (*itemEqual)(T &, T &) = 0);
+    // PersistentList(items, n), PersistentList(list): a first version holding a copy of the items, built in O(n)
+    PersistentList(const T *items, int n, bool (*itemEqual)(T &, T &) = 0);
+    PersistentList(IList<T> &list, bool (*itemEqual)(T &, T &) = 0);
+    PersistentList(const PersistentList<T> &list);
+    PersistentList<T> &operator=(const PersistentList<T> &list);
+    ~PersistentList();
+
+    // Inherit from IList: BEGIN
+    // the mutators throw std::logic_error: a version never changes
+    void add(T e);
+    void add(int index, T e);
+    T removeAt(int index);
+    bool removeItem(T item, void (*removeItemData)(T) = 0);
+    bool empty();
+    int size();
+    void clear();
+    T &get(int index);
+    int indexOf(T item);
+    bool contains(T item);
+    string toString(string (*item2str)(T &) = 0);
+    void addAll(const T *items, int n);
+    void addAll(IList<T> &list);
+    void insertRange(int index, const T *first, const T *last);
+    void removeRange(int from, int to);
+    void sort(bool (*comparator)(T &, T &) = 0);
+    void stableSort(bool (*comparator)(T &, T &) = 0);
+    // Inherit from IList: END
+
+    // New versions: this list is left unchanged
+    // push_back(e): the list with "e" appended
+    PersistentList<T> push_back(T e) const;
+    // set(index, e): the list with the item at "index" replaced by "e"
+    PersistentList<T> set(int index, T e) const;
+    // pop_back(): the list without its last item; throws std::out_of_range if empty
+    PersistentList<T> pop_back() const;
+
+    void writeTo(ostream &os, string (*item2str)(T &) = 0, int maxItems = -1);
+    void println(string (*item2str)(T &) = 0)
+    {
+        writeTo(cout, item2str);
+        cout << endl;
+    }
+
+protected:
+    static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &))
+    {
+        if (itemEqual == 0)
+            return lhs == rhs;
+        else
+            return itemEqual(lhs, rhs);
+    }
+    static void retain(Node *node)
+    {
+        if (node != 0)
+            node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    static void release(Node *node);
+    static Branch *copyBranch(Branch *branch);
+    static Leaf *copyLeaf(Leaf *leaf, int size);
+    // new version made of the given parts; the caller hands over one reference to root and tail
+    PersistentList(int count, int shift, Branch *root, Leaf *tail, bool (*itemEqual)(T &, T &));
+
+    int tailOffset() const
+    {
+        return count < WIDTH ? 0 : ((count - 1) >> BITS) << BITS;
+    }
+    // leafFor(index): the leaf (or tail) holding location "index"
+    Leaf *leafFor(int index) const;
+    void checkIndex(int index) const
+    {
+        if (index < 0 || index >= count)
+            throw out_of_range("Index is out of range!");
+    }
+    void readOnly()
+    {
+        throw logic_error("PersistentList is read-only: use push_back/set/pop_back!");
+    }
+    template <class Get>
+    void build(int n, Get get);
+    Branch *pushTail(int level, Branch *parent, Leaf *tailLeaf) const;
+    static Node *newPath(int level, Node *node);
+    static Node *assoc(int level, Node *node, int index, T &e);
+    Branch *popTail(int level, Branch *node) const;
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+PersistentList<T>::PersistentList(bool (*itemEqual)(T &, T &))
+{
+    this->itemEqual = itemEqual;
+    this->count = 0;
+    this->shift = BITS;
+    this->root = new Branch();
+    this->tail = new Leaf();
+}
+
+template <class T>
+PersistentList<T>::PersistentList(const T *items, int n, bool (*itemEqual)(T &, T &))
+{
+    this->itemEqual = itemEqual;
+    build(n, [items](int index) -> const T &
+          { return items[index]; });
+}
+
+template <class T>
+PersistentList<T>::PersistentList(IList<T> &list, bool (*itemEqual)(T &, T &))
+{
+    this->itemEqual = itemEqual;
+    build(list.size(), [&list](int index) -> const T &
+          { return list.get(index); });
+}
+
+template <class T>
+PersistentList<T>::PersistentList(int count, int shift, Branch *root, Leaf *tail, bool (*itemEqual)(T &, T &))
+{
+    this->count = count;
+    this->shift = shift;
+    this->root = root;
+    this->tail = tail;
+    this->itemEqual = itemEqual;
+}
+
+template <class T>
+PersistentList<T>::PersistentList(const PersistentList<T> &list)
+{
+    count = list.count;
+    shift = list.shift;
+    root = list.root;
+    tail = list.tail;
+    itemEqual = list.itemEqual;
+    retain(root);
+    retain(tail);
+}
+
+template <class T>
+PersistentList<T> &PersistentList<T>::operator=(const PersistentList<T> &list)
+{
+    if (this != &list)
+    {
+        retain(list.root);
+        retain(list.tail);
+        release(root);
+        release(tail);
+        count = list.count;
+        shift = list.shift;
+        root = list.root;
+        tail = list.tail;
+        itemEqual = list.itemEqual;
+    }
+    return *this;
+}
+
+template <class T>
+PersistentList<T>::~PersistentList()
+{
+    release(root);
+    release(tail);
+}
+
+template <class T>
+void PersistentList<T>::add(T /*e*/)
+{
+    readOnly();
+}
+
+template <class T>
+void PersistentList<T>::add(int /*index*/, T /*e*/)
+{
+    readOnly();
+}
+
+template <class T>
+T PersistentList<T>::removeAt(int index)
+{
+    readOnly();
+    return get(index);
+}
+
+template <class T>
+bool PersistentList<T>::removeItem(T /*item*/, void (* /*removeItemData*/)(T))
+{
+    readOnly();
+    return false;
+}
+
+template <class T>
+bool PersistentList<T>::empty()
+{
+    return count == 0;
+}
+
+template <class T>
+int PersistentList<T>::size()
+{
+    return count;
+}
+
+template <class T>
+void PersistentList<T>::clear()
+{
+    readOnly();
+}
+
+template <class T>
+T &PersistentList<T>::get(int index)
+{
+    checkIndex(index);
+    return leafFor(index)->items()[index & MASK];
+}
+
+template <class T>
+int PersistentList<T>::indexOf(T item)
+{
+    for (int first = 0; first < count; first += WIDTH)
+    {
+        Leaf *leaf = leafFor(first);
+        for (int i = 0; i < leaf->size; i++)
+        {
+            if (equals(leaf->items()[i], item, itemEqual))
+                return first + i;
+        }
+    }
+    return -1;
+}
+
+template <class T>
+bool PersistentList<T>::contains(T item)
+{
+    return indexOf(std::move(item)) != -1;
+}
+
+template <class T>
+string PersistentList<T>::toString(string (*item2str)(T &))
+{
+    stringstream ss;
+    writeTo(ss, item2str);
+    return ss.str();
+}
+
+template <class T>
+void PersistentList<T>::writeTo(ostream &os, string (*item2str)(T &), int maxItems)
+{
+    XListWriter<T> writer(os, item2str, maxItems);
+    for (int first = 0; first < count && !writer.full(); first += WIDTH)
+    {
+        Leaf *leaf = leafFor(first);
+        for (int i = 0; i < leaf->size && !writer.full(); i++)
+        {
+            writer.item(leaf->items()[i]);
+        }
+    }
+    writer.finish(count);
+}
+
+template <class T>
+void PersistentList<T>::addAll(const T * /*items*/, int /*n*/)
+{
+    readOnly();
+}
+
+template <class T>
+void PersistentList<T>::addAll(IList<T> & /*list*/)
+{
+    readOnly();
+}
+
+template <class T>
+void PersistentList<T>::insertRange(int /*index*/, const T * /*first*/, const T * /*last*/)
+{
+    readOnly();
+}
+
+template <class T>
+void PersistentList<T>::removeRange(int /*from*/, int /*to*/)
+{
+    readOnly();
+}
+
+template <class T>
+void PersistentList<T>::sort(bool (* /*comparator*/)(T &, T &))
+{
+    readOnly();
+}
+
+template <class T>
+void PersistentList<T>::stableSort(bool (* /*comparator*/)(T &, T &))
+{
+    readOnly();
+}
+
+template <class T>
+PersistentList<T> PersistentList<T>::push_back(T e) const
+{
+    if (count - tailOffset() < WIDTH)
+    {
+        // room in the tail: copy it with one more item, share the whole tree
+        Leaf *newTail = copyLeaf(tail, tail->size);
+        newTail->append(e);
+        retain(root);
+        return PersistentList<T>(count + 1, shift, root, newTail, itemEqual);
+    }
+
+    // full tail: it moves into the tree, "e" starts a new tail
+    Branch *newRoot;
+    int newShift = shift;
+    retain(tail);
+    if ((count >> BITS) > (1 << shift))
+    {
+        // the tree is full: add a level
+        newRoot = new Branch();
+        retain(root);
+        newRoot->children[0] = root;
+        newRoot->children[1] = newPath(shift, tail);
+        newShift += BITS;
+    }
+    else
+    {
+        newRoot = pushTail(shift, root, tail);
+    }
+    Leaf *newTail = new Leaf();
+    newTail->append(e);
+    return PersistentList<T>(count + 1, newShift, newRoot, newTail, itemEqual);
+}
+
+template <class T>
+PersistentList<T> PersistentList<T>::set(int index, T e) const
+{
+    checkIndex(index);
+    if (index >= tailOffset())
+    {
+        Leaf *newTail = copyLeaf(tail, tail->size);
+        newTail->items()[index & MASK] = e;
+        retain(root);
+        return PersistentList<T>(count, shift, root, newTail, itemEqual);
+    }
+    Branch *newRoot = static_cast<Branch *>(assoc(shift, root, index, e));
+    retain(tail);
+    return PersistentList<T>(count, shift, newRoot, tail, itemEqual);
+}
+
+template <class T>
+PersistentList<T> PersistentList<T>::pop_back() const
+{
+    if (count == 0)
+    {
+        throw out_of_range("List is empty!");
+    }
+    if (count == 1)
+    {
+        return PersistentList<T>(itemEqual);
+    }
+    if (count - tailOffset() > 1)
+    {
+        Leaf *newTail = copyLeaf(tail, tail->size - 1);
+        retain(root);
+        return PersistentList<T>(count - 1, shift, root, newTail, itemEqual);
+    }
+
+    // the tail empties: the last leaf of the tree becomes the new tail
+    Leaf *newTail = leafFor(count - 2);
+    retain(newTail);
+    Branch *newRoot = popTail(shift, root);
+    int newShift = shift;
+    if (newRoot == 0)
+    {
+        newRoot = new Branch();
+    }
+    if (shift > BITS && newRoot->children[1] == 0)
+    {
+        // the root has a single child left: drop a level
+        Branch *child = static_cast<Branch *>(newRoot->children[0]);
+        retain(child);
+        release(newRoot);
+        newRoot = child;
+        newShift -= BITS;
+    }
+    return PersistentList<T>(count - 1, newShift, newRoot, newTail, itemEqual);
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T>
+void PersistentList<T>::release(Node *node)
+{
+    if (node == 0 || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    if (node->leaf)
+    {
+        delete static_cast<Leaf *>(node);
+    }
+    else
+    {
+        Branch *branch = static_cast<Branch *>(node);
+        for (int i = 0; i < WIDTH; i++)
+            release(branch->children[i]);
+        delete branch;
+    }
+}
+
+template <class T>
+typename PersistentList<T>::Branch *PersistentList<T>::copyBranch(Branch *branch)
+{
+    Branch *copy = new Branch();
+    for (int i = 0; i < WIDTH; i++)
+    {
+        copy->children[i] = branch->children[i];
+        retain(copy->children[i]);
+    }
+    return copy;
+}
+
+template <class T>
+typename PersistentList<T>::Leaf *PersistentList<T>::copyLeaf(Leaf *leaf, int size)
+{
+    Leaf *copy = new Leaf();
+    for (int i = 0; i < size; i++)
+        copy->append(leaf->items()[i]);
+    return copy;
+}
+
+template <class T>
+typename PersistentList<T>::Leaf *PersistentList<T>::leafFor(int index) const
+{
+    if (index >= tailOffset())
+        return tail;
+    Node *node = root;
+    for (int level = shift; level > 0; level -= BITS)
+        node = static_cast<Branch *>(node)->children[(index >> level) & MASK];
+    return static_cast<Leaf *>(node);
+}
+
+template <class T>
+template <class Get>
+void PersistentList<T>::build(int n, Get get)
+{
+    count = n;
+    shift = BITS;
+    int tailStart = tailOffset();
+
+    // full leaves first, then one level of branches at a time until a single root is left
+    vector<Node *> level;
+    for (int first = 0; first < tailStart; first += WIDTH)
+    {
+        Leaf *leaf = new Leaf();
+        for (int i = first; i < first + WIDTH; i++)
+            leaf->append(get(i));
+        level.push_back(leaf);
+    }
+    tail = new Leaf();
+    for (int i = tailStart; i < n; i++)
+        tail->append(get(i));
+
+    if (level.empty())
+    {
+        root = new Branch();
+        return;
+    }
+    while (true)
+    {
+        vector<Node *> parents;
+        for (size_t first = 0; first < level.size(); first += WIDTH)
+        {
+            Branch *branch = new Branch();
+            for (size_t i = first; i < level.size() && i < first + WIDTH; i++)
+                branch->children[i - first] = level[i];
+            parents.push_back(branch);
+        }
+        if (parents.size() == 1)
+        {
+            root = static_cast<Branch *>(parents[0]);
+            return;
+        }
+        shift += BITS;
+        level.swap(parents);
+    }
+}
+
+template <class T>
+typename PersistentList<T>::Branch *PersistentList<T>::pushTail(int level, Branch *parent, Leaf *tailLeaf) const
+{
+    int subIndex = ((count - 1) >> level) & MASK;
+    Branch *copy = copyBranch(parent);
+    Node *old = copy->children[subIndex];
+    if (level == BITS)
+        copy->children[subIndex] = tailLeaf;
+    else if (old != 0)
+        copy->children[subIndex] = pushTail(level - BITS, static_cast<Branch *>(old), tailLeaf);
+    else
+        copy->children[subIndex] = newPath(level - BITS, tailLeaf);
+    release(old);
+    return copy;
+}
+
+template <class T>
+typename PersistentList<T>::Node *PersistentList<T>::newPath(int level, Node *node)
+{
+    if (level == 0)
+        return node;
+    Branch *branch = new Branch();
+    branch->children[0] = newPath(level - BITS, node);
+    return branch;
+}
+
+template <class T>
+typename PersistentList<T>::Node *PersistentList<T>::assoc(int level, Node *node, int index, T &e)
+{
+    if (level == 0)
+    {
+        Leaf *leaf = static_cast<Leaf *>(node);
+        Leaf *copy = copyLeaf(leaf, leaf->size);
+        copy->items()[index & MASK] = e;
+        return copy;
+    }
+    Branch *copy = copyBranch(static_cast<Branch *>(node));
+    int subIndex = (index >> level) & MASK;
+    Node *old = copy->children[subIndex];
+    copy->children[subIndex] = assoc(level - BITS, old, index, e);
+    release(old);
+    return copy;
+}
+
+template <class T>
+typename PersistentList<T>::Branch *PersistentList<T>::popTail(int level, Branch *node) const
+{
+    int subIndex = ((count - 2) >> level) & MASK;
+    if (level > BITS)
+    {
+        Branch *newChild = popTail(level - BITS, static_cast<Branch *>(node->children[subIndex]));
+        if (newChild == 0 && subIndex == 0)
+            return 0;
+        Branch *copy = copyBranch(node);
+        release(copy->children[subIndex]);
+        copy->children[subIndex] = newChild;
+        return copy;
+    }
+    if (subIndex == 0)
+        return 0;
+    Branch *copy = copyBranch(node);
+    release(copy->children[subIndex]);
+    copy->children[subIndex] = 0;
+    return copy;
+}
+
+#endif /* PERSISTENTLIST_H */
@@ -0,0 +1,646 @@
+/*
+ * File:   UnrolledLinkedList.h
+ *
+ * A doubly linked list of blocks, each holding up to BlockSize items in
+ * contiguous storage: index lookups hop block by block instead of node by
+ * node, and iteration walks arrays, while insertions in the middle still
+ * only shift the items of one block.
+ */
+
+#ifndef UNROLLEDLINKEDLIST_H
+#define UNROLLEDLINKEDLIST_H
+
+#include "list/IList.h"
+#include "list/ListFormat.h"
+#include "list/ListSort.h"
+
+#include <sstream>
+#include <iostream>
+#include <new>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+template <class T, int BlockSize = 64>
+class UnrolledLinkedList : public IList<T>
+{
+    static_assert(BlockSize >= 4, "UnrolledLinkedList: BlockSize must be at least 4");
+
+public:
+    class Block;    // Forward declaration
+    class Iterator; // Forward declaration
+
+protected:
+    Block *head; // first block, 0 if the list is empty
+    Block *tail; // last block, 0 if the list is empty
+    int count;
+    bool (*itemEqual)(T &lhs, T &rhs);                           // function pointer: test if two items (type: T&) are equal or not
+    void (*deleteUserData)(UnrolledLinkedList<T, BlockSize> *); // function pointer: be called to remove items (if they are pointer type)
+
+public:
+    UnrolledLinkedList(
+        void (*deleteUserData)(UnrolledLinkedList<T, BlockSize> *) = 0,
+        bool (*itemEqual)(T &, T &) = 0);
+    UnrolledLinkedList(const UnrolledLinkedList<T, BlockSize> &list);
+    UnrolledLinkedList<T, BlockSize> &operator=(const UnrolledLinkedList<T, BlockSize> &list);
+    ~UnrolledLinkedList();
+
+    // Inherit from IList: BEGIN
+    void add(T e);
+    void add(int index, T e);
+    T removeAt(int index);
+    bool removeItem(T item, void (*removeItemData)(T) = 0);
+    bool empty();
+    int size();
+    void clear();
+    T &get(int index);
+    int indexOf(T item);
+    bool contains(T item);
+    string toString(string (*item2str)(T &) = 0);
+    void forEachItem(void (*visit)(const T &, void *), void *context);
+    void sort(bool (*comparator)(T &, T &) = 0);
+    void stableSort(bool (*comparator)(T &, T &) = 0);
+    // Inherit from IList: END
+
+    // writeTo(os, item2str, maxItems): stream the list as toString() does, chunk by chunk;
+    //      at most maxItems items are written (-1: all), the rest is shown as "..."
+    void writeTo(ostream &os, string (*item2str)(T &) = 0, int maxItems = -1);
+
+    void println(string (*item2str)(T &) = 0)
+    {
+        writeTo(cout, item2str);
+        cout << endl;
+    }
+    void setDeleteUserDataPtr(void (*deleteUserData)(UnrolledLinkedList<T, BlockSize> *) = 0)
+    {
+        this->deleteUserData = deleteUserData;
+    }
+
+    static void free(UnrolledLinkedList<T, BlockSize> *list)
+    {
+        typename UnrolledLinkedList<T, BlockSize>::Iterator it = list->begin();
+        while (it != list->end())
+        {
+            delete *it;
+            it++;
+        }
+    }
+
+    Iterator begin()
+    {
+        return Iterator(this, 0, head, 0);
+    }
+    Iterator end()
+    {
+        return Iterator(this, count, 0, 0);
+    }
+
+protected:
+    static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &))
+    {
+        if (itemEqual == 0)
+            return lhs == rhs;
+        else
+            return itemEqual(lhs, rhs);
+    }
+    void copyFrom(const UnrolledLinkedList<T, BlockSize> &list);
+    void removeInternalData();
+
+    // locate(index, offset): block holding location "index" (walking from the nearer end)
+    Block *locate(int index, int &offset);
+    // insertBlockAfter: link a new, empty block after "block" (0: in front of head)
+    Block *insertBlockAfter(Block *block);
+    void unlinkBlock(Block *block);
+    // split: move the upper half of a full block into a new block after it
+    void split(Block *block);
+    // mergeNext: append the items of block->next to block and drop block->next
+    void mergeNext(Block *block);
+    // removeFromBlock: erase the item at "offset" and rebalance the block
+    T removeFromBlock(Block *block, int offset);
+    // sortBlocks: move the items into one array, sort it and move them back block by block
+    void sortBlocks(bool (*comparator)(T &, T &), bool stable);
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    class Block
+    {
+    public:
+        int size; // items constructed in [0, size)
+        Block *next;
+        Block *prev;
+        friend class UnrolledLinkedList<T, BlockSize>;
+
+    private:
+        alignas(T) unsigned char storage[BlockSize * sizeof(T)];
+
+    public:
+        Block(Block *next = 0, Block *prev = 0)
+        {
+            this->size = 0;
+            this->next = next;
+            this->prev = prev;
+        }
+        T *items()
+        {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+        T &operator[](int offset)
+        {
+            return items()[offset];
+        }
+        // insert: construct "e" at "offset", shifting the items behind it (requires size < BlockSize)
+        void insert(int offset, T &&e)
+        {
+            T *ptr = items();
+            if (offset == size)
+            {
+                new (ptr + size) T(std::move(e));
+            }
+            else
+            {
+                new (ptr + size) T(std::move(ptr[size - 1]));
+                for (int i = size - 1; i > offset; i--)
+                    ptr[i] = std::move(ptr[i - 1]);
+                ptr[offset] = std::move(e);
+            }
+            size++;
+        }
+        // erase: move the item at "offset" out and close the hole
+        T erase(int offset)
+        {
+            T *ptr = items();
+            T item = std::move(ptr[offset]);
+            for (int i = offset; i < size - 1; i++)
+                ptr[i] = std::move(ptr[i + 1]);
+            ptr[size - 1].~T();
+            size--;
+            return item;
+        }
+        void destroyItems()
+        {
+            T *ptr = items();
+            for (int i = 0; i < size; i++)
+                ptr[i].~T();
+            size = 0;
+        }
+    };
+
+    //////////////////////////////////////////////////////////////////////
+    class Iterator
+    {
+    private:
+        UnrolledLinkedList<T, BlockSize> *pList;
+        int index;    // location of the current item
+        Block *block; // block of the current item (0 at end or before the first item)
+        int offset;   // location of the current item inside "block"
+
+    public:
+        Iterator(UnrolledLinkedList<T, BlockSize> *pList = 0, int index = 0, Block *block = 0, int offset = 0)
+        {
+            this->pList = pList;
+            this->index = index;
+            this->block = block;
+            this->offset = offset;
+        }
+        Iterator &operator=(const Iterator &iterator)
+        {
+            this->pList = iterator.pList;
+            this->index = iterator.index;
+            this->block = iterator.block;
+            this->offset = iterator.offset;
+            return *this;
+        }
+        void remove(void (*removeItemData)(T) = 0)
+        {
+            T item = pList->removeAt(index);
+            if (removeItemData != 0)
+                removeItemData(item);
+            index -= 1; // MUST keep index of previous, for ++ later
+            if (index >= 0)
+                block = pList->locate(index, offset);
+            else
+                block = 0;
+        }
+
+        T &operator*()
+        {
+            return (*block)[offset];
+        }
+        bool operator!=(const Iterator &iterator)
+        {
+            return index != iterator.index;
+        }
+        // Prefix ++ overload
+        Iterator &operator++()
+        {
+            index++;
+            if (block == 0)
+            {
+                // before the first item (after removing it)
+                block = pList->head;
+                offset = 0;
+            }
+            else if (++offset == block->size)
+            {
+                block = block->next;
+                offset = 0;
+            }
+            return *this;
+        }
+        // Postfix ++ overload
+        Iterator operator++(int)
+        {
+            Iterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+    };
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T, int BlockSize>
+UnrolledLinkedList<T, BlockSize>::UnrolledLinkedList(
+    void (*deleteUserData)(UnrolledLinkedList<T, BlockSize> *), bool (*itemEqual)(T &, T &))
+{
+    this->deleteUserData = deleteUserData;
+    this->itemEqual = itemEqual;
+    this->count = 0;
+    this->head = 0;
+    this->tail = 0;
+}
+
+template <class T, int BlockSize>
+UnrolledLinkedList<T, BlockSize>::UnrolledLinkedList(const UnrolledLinkedList<T, BlockSize> &list)
+{
+    this->deleteUserData = list.deleteUserData;
+    this->itemEqual = list.itemEqual;
+    this->count = 0;
+    this->head = 0;
+    this->tail = 0;
+    copyFrom(list);
+}
+
+template <class T, int BlockSize>
+UnrolledLinkedList<T, BlockSize> &UnrolledLinkedList<T, BlockSize>::operator=(const UnrolledLinkedList<T, BlockSize> &list)
+{
+    if (this == &list)
+    {
+        return *this;
+    }
+    removeInternalData();
+    this->deleteUserData = list.deleteUserData;
+    this->itemEqual = list.itemEqual;
+    copyFrom(list);
+    return *this;
+}
+
+template <class T, int BlockSize>
+UnrolledLinkedList<T, BlockSize>::~UnrolledLinkedList()
+{
+    if (deleteUserData)
+    {
+        deleteUserData(this);
+    }
+    removeInternalData();
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::copyFrom(const UnrolledLinkedList<T, BlockSize> &list)
+{
+    // copied blocks are packed full, whatever the fill of the source
+    for (Block *source = list.head; source != 0; source = source->next)
+    {
+        for (int i = 0; i < source->size; i++)
+        {
+            add((*source)[i]);
+        }
+    }
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::removeInternalData()
+{
+    Block *current = head;
+    while (current != 0)
+    {
+        Block *nextBlock = current->next;
+        current->destroyItems();
+        delete current;
+        current = nextBlock;
+    }
+    head = tail = 0;
+    count = 0;
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::add(T e)
+{
+    if (tail == 0 || tail->size == BlockSize)
+    {
+        // appending: leave the full block full, start a new one
+        insertBlockAfter(tail);
+    }
+    tail->insert(tail->size, std::move(e));
+    count++;
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::add(int index, T e)
+{
+    if (index < 0 || index > count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    if (index == count)
+    {
+        add(std::move(e));
+        return;
+    }
+
+    int offset;
+    Block *block = locate(index, offset);
+    if (block->size == BlockSize)
+    {
+        split(block);
+        if (offset >= block->size)
+        {
+            offset -= block->size;
+            block = block->next;
+        }
+    }
+    block->insert(offset, std::move(e));
+    count++;
+}
+
+template <class T, int BlockSize>
+T UnrolledLinkedList<T, BlockSize>::removeAt(int index)
+{
+    if (index < 0 || index >= count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    int offset;
+    Block *block = locate(index, offset);
+    return removeFromBlock(block, offset);
+}
+
+template <class T, int BlockSize>
+T UnrolledLinkedList<T, BlockSize>::removeFromBlock(Block *block, int offset)
+{
+    T item = block->erase(offset);
+    count--;
+
+    if (block->size == 0)
+    {
+        unlinkBlock(block);
+    }
+    else if (block->size < BlockSize / 4)
+    {
+        // keep blocks at least a quarter full: merge with a neighbour that has room
+        if (block->next != 0 && block->size + block->next->size <= BlockSize)
+            mergeNext(block);
+        else if (block->prev != 0 && block->prev->size + block->size <= BlockSize)
+            mergeNext(block->prev);
+    }
+    return item;
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::forEachItem(void (*visit)(const T &, void *), void *context)
+{
+    for (Block *block = head; block != 0; block = block->next)
+    {
+        for (int i = 0; i < block->size; i++)
+            visit((*block)[i], context);
+    }
+}
+
+template <class T, int BlockSize>
+bool UnrolledLinkedList<T, BlockSize>::removeItem(T item, void (*removeItemData)(T))
+{
+    for (Block *block = head; block != 0; block = block->next)
+    {
+        for (int i = 0; i < block->size; i++)
+        {
+            if (equals((*block)[i], item, itemEqual))
+            {
+                T removed = removeFromBlock(block, i);
+                if (removeItemData != 0)
+                    removeItemData(removed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+template <class T, int BlockSize>
+bool UnrolledLinkedList<T, BlockSize>::empty()
+{
+    return count == 0;
+}
+
+template <class T, int BlockSize>
+int UnrolledLinkedList<T, BlockSize>::size()
+{
+    return count;
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::clear()
+{
+    removeInternalData();
+}
+
+template <class T, int BlockSize>
+T &UnrolledLinkedList<T, BlockSize>::get(int index)
+{
+    if (index < 0 || index >= count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    int offset;
+    Block *block = locate(index, offset);
+    return (*block)[offset];
+}
+
+template <class T, int BlockSize>
+int UnrolledLinkedList<T, BlockSize>::indexOf(T item)
+{
+    int base = 0;
+    for (Block *block = head; block != 0; block = block->next)
+    {
+        for (int i = 0; i < block->size; i++)
+        {
+            if (equals((*block)[i], item, itemEqual))
+            {
+                return base + i;
+            }
+        }
+        base += block->size;
+    }
+    return -1;
+}
+
+template <class T, int BlockSize>
+bool UnrolledLinkedList<T, BlockSize>::contains(T item)
+{
+    return indexOf(item) != -1;
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::sort(bool (*comparator)(T &, T &))
+{
+    sortBlocks(comparator, false);
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::stableSort(bool (*comparator)(T &, T &))
+{
+    sortBlocks(comparator, true);
+}
+
+template <class T, int BlockSize>
+string UnrolledLinkedList<T, BlockSize>::toString(string (*item2str)(T &))
+{
+    stringstream ss;
+    writeTo(ss, item2str);
+    return ss.str();
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::writeTo(ostream &os, string (*item2str)(T &), int maxItems)
+{
+    XListWriter<T> writer(os, item2str, maxItems);
+    for (Block *block = head; block != 0 && !writer.full(); block = block->next)
+    {
+        for (int i = 0; i < block->size && !writer.full(); i++)
+        {
+            writer.item((*block)[i]);
+        }
+    }
+    writer.finish(count);
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T, int BlockSize>
+typename UnrolledLinkedList<T, BlockSize>::Block *UnrolledLinkedList<T, BlockSize>::locate(int index, int &offset)
+{
+    Block *block;
+    if (index < count / 2)
+    {
+        block = head;
+        while (index >= block->size)
+        {
+            index -= block->size;
+            block = block->next;
+        }
+        offset = index;
+    }
+    else
+    {
+        int remain = count - 1 - index; // items behind "index"
+        block = tail;
+        while (remain >= block->size)
+        {
+            remain -= block->size;
+            block = block->prev;
+        }
+        offset = block->size - 1 - remain;
+    }
+    return block;
+}
+
+template <class T, int BlockSize>
+typename UnrolledLinkedList<T, BlockSize>::Block *UnrolledLinkedList<T, BlockSize>::insertBlockAfter(Block *block)
+{
+    Block *newBlock = new Block();
+    Block *nextBlock = block != 0 ? block->next : head;
+    newBlock->prev = block;
+    newBlock->next = nextBlock;
+    if (block != 0)
+        block->next = newBlock;
+    else
+        head = newBlock;
+    if (nextBlock != 0)
+        nextBlock->prev = newBlock;
+    else
+        tail = newBlock;
+    return newBlock;
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::unlinkBlock(Block *block)
+{
+    if (block->prev != 0)
+        block->prev->next = block->next;
+    else
+        head = block->next;
+    if (block->next != 0)
+        block->next->prev = block->prev;
+    else
+        tail = block->prev;
+    block->destroyItems();
+    delete block;
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::split(Block *block)
+{
+    Block *newBlock = insertBlockAfter(block);
+    int half = block->size / 2;
+    T *from = block->items();
+    T *to = newBlock->items();
+    for (int i = half; i < block->size; i++)
+    {
+        new (to + i - half) T(std::move(from[i]));
+        from[i].~T();
+    }
+    newBlock->size = block->size - half;
+    block->size = half;
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::mergeNext(Block *block)
+{
+    Block *nextBlock = block->next;
+    T *from = nextBlock->items();
+    T *to = block->items();
+    for (int i = 0; i < nextBlock->size; i++)
+    {
+        new (to + block->size + i) T(std::move(from[i]));
+        from[i].~T();
+    }
+    block->size += nextBlock->size;
+    nextBlock->size = 0;
+    unlinkBlock(nextBlock);
+}
+
+template <class T, int BlockSize>
+void UnrolledLinkedList<T, BlockSize>::sortBlocks(bool (*comparator)(T &, T &), bool stable)
+{
+    xsortCheck(comparator);
+    XSortBuffer<T> items(count);
+    for (Block *block = head; block != 0; block = block->next)
+    {
+        for (int offset = 0; offset < block->size; offset++)
+            items.push(std::move((*block)[offset]));
+    }
+    xsortRange(items.begin(), items.end(), comparator, stable);
+    int index = 0;
+    for (Block *block = head; block != 0; block = block->next)
+    {
+        for (int offset = 0; offset < block->size; offset++)
+            (*block)[offset] = std::move(items[index++]);
+    }
+}
+
+#endif /* UNROLLEDLINKEDLIST_H */
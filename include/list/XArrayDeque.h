@@ -0,0 +1,537 @@
+/*
+ * File:   XArrayDeque.h
+ *
+ * A ring buffer implementing IList: items live in one power-of-two array,
+ * starting at "head" and wrapping around its end. Adding/removing at either
+ * end is O(1) amortized, get(index) is a masked array access, and an
+ * insertion/removal in the middle shifts the shorter side only.
+ */
+
+#ifndef XARRAYDEQUE_H
+#define XARRAYDEQUE_H
+#include "list/IList.h"
+#include "list/ListFormat.h"
+#include "list/ListSort.h"
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+template <class T, class Alloc = std::allocator<T>>
+class XArrayDeque : public IList<T>
+{
+public:
+    class Iterator; // forward declaration
+
+protected:
+    typedef std::allocator_traits<Alloc> AllocTraits;
+
+    Alloc alloc;                                   // allocator of the raw storage behind "data"
+    T *data;                                       // ring buffer; only the "count" slots from "head" are constructed
+    int capacity;                                  // size of the ring buffer, a power of 2
+    int head;                                      // slot of the item at location 0
+    int count;                                     // number of items stored in the ring
+    bool (*itemEqual)(T &lhs, T &rhs);             // function pointer: test if two items (type: T&) are equal or not
+    void (*deleteUserData)(XArrayDeque<T, Alloc> *); // function pointer: be called to remove items (if they are pointer type)
+
+public:
+    XArrayDeque(
+        void (*deleteUserData)(XArrayDeque<T, Alloc> *) = 0,
+        bool (*itemEqual)(T &, T &) = 0,
+        int capacity = 16);
+    XArrayDeque(const XArrayDeque<T, Alloc> &list);
+    XArrayDeque<T, Alloc> &operator=(const XArrayDeque<T, Alloc> &list);
+    ~XArrayDeque();
+
+    // Inherit from IList: BEGIN
+    void add(T e);
+    void add(int index, T e);
+    T removeAt(int index);
+    bool removeItem(T item, void (*removeItemData)(T) = 0);
+    bool empty();
+    int size();
+    void clear();
+    T &get(int index);
+    int indexOf(T item);
+    bool contains(T item);
+    string toString(string (*item2str)(T &) = 0);
+    void sort(bool (*comparator)(T &, T &) = 0);
+    void stableSort(bool (*comparator)(T &, T &) = 0);
+    // Inherit from IList: END
+
+    // Deque operations: O(1) amortized at both ends
+    void push_front(T e);
+    void push_back(T e);
+    // pop_front(), pop_back(): remove and return the first/last item;
+    //      throw std::out_of_range if the deque is empty
+    T pop_front();
+    T pop_back();
+    T &front();
+    T &back();
+    // reserve(n): make room for at least n items with at most one reallocation
+    void reserve(int n);
+
+    // writeTo(os, item2str, maxItems): stream the list as toString() does, chunk by chunk;
+    //      at most maxItems items are written (-1: all), the rest is shown as "..."
+    void writeTo(ostream &os, string (*item2str)(T &) = 0, int maxItems = -1);
+
+    void println(string (*item2str)(T &) = 0)
+    {
+        writeTo(cout, item2str);
+        cout << endl;
+    }
+    void setDeleteUserDataPtr(void (*deleteUserData)(XArrayDeque<T, Alloc> *) = 0)
+    {
+        this->deleteUserData = deleteUserData;
+    }
+
+    Iterator begin()
+    {
+        return Iterator(this, 0);
+    }
+    Iterator end()
+    {
+        return Iterator(this, count);
+    }
+
+    static void free(XArrayDeque<T, Alloc> *list)
+    {
+        typename XArrayDeque<T, Alloc>::Iterator it = list->begin();
+        while (it != list->end())
+        {
+            delete *it;
+            it++;
+        }
+    }
+
+protected:
+    static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &))
+    {
+        if (itemEqual == 0)
+            return lhs == rhs;
+        else
+            return itemEqual(lhs, rhs);
+    }
+    // slot(index): the item at location "index"
+    T &slot(int index)
+    {
+        return data[(head + index) & (capacity - 1)];
+    }
+    T *slotPtr(int index)
+    {
+        return data + ((head + index) & (capacity - 1));
+    }
+    void copyFrom(const XArrayDeque<T, Alloc> &list);
+    void removeInternalData();
+    // reallocate: move the items, unwrapped, into a new ring of newCapacity slots
+    void reallocate(int newCapacity);
+    // unwrap: make the items contiguous, [data + head, data + head + count)
+    void unwrap()
+    {
+        if (head + count > capacity)
+            reallocate(capacity);
+    }
+    void ensureRoom()
+    {
+        if (count == capacity)
+            reallocate(capacity * 2);
+    }
+    static int roundCapacity(int n)
+    {
+        int rounded = 4;
+        while (rounded < n)
+            rounded *= 2;
+        return rounded;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    ////////////////////////  INNER CLASSES DEFNITION ////////////////////
+    //////////////////////////////////////////////////////////////////////
+public:
+    // Iterator: BEGIN
+    class Iterator
+    {
+    private:
+        int cursor;
+        XArrayDeque<T, Alloc> *pList;
+
+    public:
+        Iterator(XArrayDeque<T, Alloc> *pList = 0, int index = 0)
+        {
+            this->pList = pList;
+            this->cursor = index;
+        }
+        Iterator &operator=(const Iterator &iterator)
+        {
+            cursor = iterator.cursor;
+            pList = iterator.pList;
+            return *this;
+        }
+        void remove(void (*removeItemData)(T) = 0)
+        {
+            T item = pList->removeAt(cursor);
+            if (removeItemData != 0)
+                removeItemData(item);
+            cursor -= 1; // MUST keep index of previous, for ++ later
+        }
+
+        T &operator*()
+        {
+            return pList->slot(cursor);
+        }
+        bool operator!=(const Iterator &iterator)
+        {
+            return cursor != iterator.cursor;
+        }
+        // Prefix ++ overload
+        Iterator &operator++()
+        {
+            this->cursor++;
+            return *this;
+        }
+        // Postfix ++ overload
+        Iterator operator++(int)
+        {
+            Iterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+    };
+    // Iterator: END
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T, class Alloc>
+XArrayDeque<T, Alloc>::XArrayDeque(
+    void (*deleteUserData)(XArrayDeque<T, Alloc> *),
+    bool (*itemEqual)(T &, T &),
+    int capacity)
+{
+    this->deleteUserData = deleteUserData;
+    this->itemEqual = itemEqual;
+    this->capacity = roundCapacity(capacity);
+    this->head = 0;
+    this->count = 0;
+    data = AllocTraits::allocate(alloc, this->capacity);
+}
+
+template <class T, class Alloc>
+XArrayDeque<T, Alloc>::XArrayDeque(const XArrayDeque<T, Alloc> &list)
+    : alloc(AllocTraits::select_on_container_copy_construction(list.alloc))
+{
+    this->capacity = 0;
+    this->count = 0;
+    this->data = 0;
+    copyFrom(list);
+}
+
+template <class T, class Alloc>
+XArrayDeque<T, Alloc> &XArrayDeque<T, Alloc>::operator=(const XArrayDeque<T, Alloc> &list)
+{
+    if (this != &list)
+    {
+        clear();
+        AllocTraits::deallocate(alloc, data, capacity);
+        copyFrom(list);
+    }
+    return *this;
+}
+
+template <class T, class Alloc>
+XArrayDeque<T, Alloc>::~XArrayDeque()
+{
+    removeInternalData();
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::copyFrom(const XArrayDeque<T, Alloc> &list)
+{
+    itemEqual = list.itemEqual;
+    deleteUserData = list.deleteUserData;
+    capacity = roundCapacity(list.count);
+    head = 0;
+    count = 0;
+    data = AllocTraits::allocate(alloc, capacity);
+    for (int i = 0; i < list.count; i++)
+    {
+        AllocTraits::construct(alloc, data + i, list.data[(list.head + i) & (list.capacity - 1)]);
+        count++;
+    }
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::removeInternalData()
+{
+    if (deleteUserData)
+    {
+        deleteUserData(this);
+    }
+    clear();
+    AllocTraits::deallocate(alloc, data, capacity);
+    data = 0;
+    capacity = 0;
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::add(T e)
+{
+    push_back(std::move(e));
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::add(int index, T e)
+{
+    if (index < 0 || index > count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    if (index == 0)
+    {
+        push_front(std::move(e));
+        return;
+    }
+    if (index == count)
+    {
+        push_back(std::move(e));
+        return;
+    }
+    ensureRoom();
+    if (index < count / 2)
+    {
+        // open the gap by moving the front part one slot to the left
+        head = (head - 1) & (capacity - 1);
+        AllocTraits::construct(alloc, slotPtr(0), std::move(slot(1)));
+        for (int i = 1; i < index; i++)
+            slot(i) = std::move(slot(i + 1));
+    }
+    else
+    {
+        // open the gap by moving the back part one slot to the right
+        AllocTraits::construct(alloc, slotPtr(count), std::move(slot(count - 1)));
+        for (int i = count - 1; i > index; i--)
+            slot(i) = std::move(slot(i - 1));
+    }
+    slot(index) = std::move(e);
+    count++;
+}
+
+template <class T, class Alloc>
+T XArrayDeque<T, Alloc>::removeAt(int index)
+{
+    if (index < 0 || index >= count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    T item = std::move(slot(index));
+    if (index < count / 2)
+    {
+        // close the gap from the front
+        for (int i = index; i > 0; i--)
+            slot(i) = std::move(slot(i - 1));
+        AllocTraits::destroy(alloc, slotPtr(0));
+        head = (head + 1) & (capacity - 1);
+    }
+    else
+    {
+        // close the gap from the back
+        for (int i = index; i < count - 1; i++)
+            slot(i) = std::move(slot(i + 1));
+        AllocTraits::destroy(alloc, slotPtr(count - 1));
+    }
+    count--;
+    return item;
+}
+
+template <class T, class Alloc>
+bool XArrayDeque<T, Alloc>::removeItem(T item, void (*removeItemData)(T))
+{
+    int index = indexOf(item);
+    if (index == -1)
+    {
+        return false;
+    }
+    T removed = removeAt(index);
+    if (removeItemData != 0)
+        removeItemData(removed);
+    return true;
+}
+
+template <class T, class Alloc>
+bool XArrayDeque<T, Alloc>::empty()
+{
+    return count == 0;
+}
+
+template <class T, class Alloc>
+int XArrayDeque<T, Alloc>::size()
+{
+    return count;
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::clear()
+{
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        for (int i = 0; i < count; i++)
+            AllocTraits::destroy(alloc, slotPtr(i));
+    }
+    head = 0;
+    count = 0;
+}
+
+template <class T, class Alloc>
+T &XArrayDeque<T, Alloc>::get(int index)
+{
+    if (index < 0 || index >= count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    return slot(index);
+}
+
+template <class T, class Alloc>
+int XArrayDeque<T, Alloc>::indexOf(T item)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (equals(slot(i), item, itemEqual))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+template <class T, class Alloc>
+bool XArrayDeque<T, Alloc>::contains(T item)
+{
+    return indexOf(item) != -1;
+}
+
+template <class T, class Alloc>
+string XArrayDeque<T, Alloc>::toString(string (*item2str)(T &))
+{
+    stringstream ss;
+    writeTo(ss, item2str);
+    return ss.str();
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::writeTo(ostream &os, string (*item2str)(T &), int maxItems)
+{
+    XListWriter<T> writer(os, item2str, maxItems);
+    for (int i = 0; i < count && !writer.full(); i++)
+    {
+        writer.item(slot(i));
+    }
+    writer.finish(count);
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::sort(bool (*comparator)(T &, T &))
+{
+    xsortCheck(comparator);
+    unwrap();
+    xsortRange(data + head, data + head + count, comparator, false);
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::stableSort(bool (*comparator)(T &, T &))
+{
+    xsortCheck(comparator);
+    unwrap();
+    xsortRange(data + head, data + head + count, comparator, true);
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::push_front(T e)
+{
+    ensureRoom();
+    head = (head - 1) & (capacity - 1);
+    AllocTraits::construct(alloc, data + head, std::move(e));
+    count++;
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::push_back(T e)
+{
+    ensureRoom();
+    AllocTraits::construct(alloc, slotPtr(count), std::move(e));
+    count++;
+}
+
+template <class T, class Alloc>
+T XArrayDeque<T, Alloc>::pop_front()
+{
+    if (count == 0)
+    {
+        throw out_of_range("List is empty!");
+    }
+    T item = std::move(data[head]);
+    AllocTraits::destroy(alloc, data + head);
+    head = (head + 1) & (capacity - 1);
+    count--;
+    return item;
+}
+
+template <class T, class Alloc>
+T XArrayDeque<T, Alloc>::pop_back()
+{
+    if (count == 0)
+    {
+        throw out_of_range("List is empty!");
+    }
+    T item = std::move(slot(count - 1));
+    AllocTraits::destroy(alloc, slotPtr(count - 1));
+    count--;
+    return item;
+}
+
+template <class T, class Alloc>
+T &XArrayDeque<T, Alloc>::front()
+{
+    return get(0);
+}
+
+template <class T, class Alloc>
+T &XArrayDeque<T, Alloc>::back()
+{
+    return get(count - 1);
+}
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::reserve(int n)
+{
+    if (n > capacity)
+    {
+        reallocate(roundCapacity(n));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+
+template <class T, class Alloc>
+void XArrayDeque<T, Alloc>::reallocate(int newCapacity)
+{
+    T *newData = AllocTraits::allocate(alloc, newCapacity);
+    for (int i = 0; i < count; i++)
+    {
+        T *item = slotPtr(i);
+        AllocTraits::construct(alloc, newData + i, std::move(*item));
+        AllocTraits::destroy(alloc, item);
+    }
+    AllocTraits::deallocate(alloc, data, capacity);
+    data = newData;
+    capacity = newCapacity;
+    head = 0;
+}
+
+#endif /* XARRAYDEQUE_H */
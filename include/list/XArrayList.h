@@ -5,32 +5,71 @@
 #ifndef XARRAYLIST_H
 #define XARRAYLIST_H
 #include "list/IList.h"
+#include "list/ListFormat.h"
+#include "list/ListFile.h"
+#include "list/ListPolicy.h"
+#include "list/ListSimd.h"
+#include "list/ListSort.h"
+#include "list/ListStats.h"
 #include <memory.h>
+#include <memory>
+#include <atomic>
 #include <sstream>
 #include <iostream>
 #include <type_traits>
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <cstddef>
 using namespace std;
 
-template <class T>
+// XAllocOwns<Alloc>: Alloc has owns(ptr), telling its own (inline) storage from heap
+//      memory that any other object of Alloc can free (XInlineAlloc)
+template <class Alloc, class = void>
+struct XAllocOwns : std::false_type
+{
+};
+template <class Alloc>
+struct XAllocOwns<Alloc, std::void_t<decltype(std::declval<const Alloc &>().owns(
+                             static_cast<const typename Alloc::value_type *>(nullptr)))>> : std::true_type
+{
+};
+
+template <class T, class Alloc = std::allocator<T>, class Growth = XGrowDouble,
+          class Equal = XEqual<T>, class Formatter = XFormatter<T>>
 class XArrayList : public IList<T>
 {
 public:
-    class Iterator; // forward declaration
+    class Iterator;      // forward declaration
+    class ConstIterator; // forward declaration
 
 protected:
-    T *data;                                 // dynamic array to store the list's items
+    typedef std::allocator_traits<Alloc> AllocTraits;
+
+    Alloc alloc;                             // allocator of the raw storage behind "data"
+    T *data;                                 // dynamic array to store the list's items; only [0, count) are constructed
     int capacity;                            // size of the dynamic array
     int count;                               // number of items stored in the array
     bool (*itemEqual)(T &lhs, T &rhs);       // function pointer: test if two items (type: T&) are equal or not
-    void (*deleteUserData)(XArrayList<T> *); // function pointer: be called to remove items (if they are pointer type)
+    void (*deleteUserData)(XArrayList<T, Alloc, Growth, Equal, Formatter> *); // function pointer: be called to remove items (if they are pointer type)
+    XListMapping mapping;                    // file mapped by mapFile (base 0 if none); "data" then points into it
+    std::atomic<int> *refs;                  // number of lists sharing "data" (copy-on-write); 0: this buffer is never shared
 
 public:
     XArrayList(
-        void (*deleteUserData)(XArrayList<T> *) = 0,
+        void (*deleteUserData)(XArrayList<T, Alloc, Growth, Equal, Formatter> *) = 0,
         bool (*itemEqual)(T &, T &) = 0,
         int capacity = 10);
-    XArrayList(const XArrayList<T> &list);
-    XArrayList<T> &operator=(const XArrayList<T> &list);
+    // Copies share the buffer of "list" until one of them changes it (copy-on-write):
+    //      every mutator, get() and the non-const begin()/end()/rawData() first give the
+    //      list its own copy. References and iterators taken before a copy was made still
+    //      point into the shared buffer. Lists of a stateful allocator (XSmallList) and
+    //      file mappings are copied right away.
+    XArrayList(const XArrayList<T, Alloc, Growth, Equal, Formatter> &list);
+    XArrayList<T, Alloc, Growth, Equal, Formatter> &operator=(const XArrayList<T, Alloc, Growth, Equal, Formatter> &list);
+    // Moves take over the buffer of "list" and leave it empty
+    XArrayList(XArrayList<T, Alloc, Growth, Equal, Formatter> &&list) noexcept(cowType);
+    XArrayList<T, Alloc, Growth, Equal, Formatter> &operator=(XArrayList<T, Alloc, Growth, Equal, Formatter> &&list) noexcept(cowType);
     ~XArrayList();
 
     // Inherit from IList: BEGIN
@@ -45,29 +84,122 @@ public:
     int indexOf(T item);
     bool contains(T item);
     string toString(string (*item2str)(T &) = 0);
+    void forEachItem(void (*visit)(const T &, void *), void *context);
+    void addAll(const T *items, int n);
+    void addAll(IList<T> &list);
+    void insertRange(int index, const T *first, const T *last);
+    void removeRange(int from, int to);
+    void sort(bool (*comparator)(T &, T &) = 0);
+    void stableSort(bool (*comparator)(T &, T &) = 0);
     // Inherit from IList: BEGIN
 
+    // clear(keepCapacity): remove all items; keepCapacity=false also returns
+    // the buffer and restores the initial capacity (clear() keeps it)
+    void clear(bool keepCapacity);
+    // reserve(n): make room for at least n items with at most one reallocation
+    void reserve(int n);
+    // shrink_to_fit(): release unused capacity
+    void shrink_to_fit();
+
+    // Bulk queries: int/float/double lists comparing with operator== scan with SIMD kernels
+    // countOf(item): number of items equal to "item"
+    int countOf(T item);
+    // findAll(item): locations of all items equal to "item", in increasing order
+    XArrayList<int> findAll(T item);
+    // min(), max(): smallest/largest item (operator<); throw std::out_of_range if the list is empty
+    T min();
+    T max();
+    // argmin(), argmax(): location of the first smallest/largest item; -1 if the list is empty
+    int argmin();
+    int argmax();
+
+    // emplace_back(args...): construct a new item at the end of the list in place
+    template <class... Args>
+    T &emplace_back(Args &&...args);
+    // emplace(index, args...): construct a new item at location "index" in place
+    template <class... Args>
+    T &emplace(int index, Args &&...args);
+
+    // sortBy(less), stableSortBy(less): sort with any callable less(a, b), which the compiler
+    //      can inline (a lambda, std::greater<T>, ...); large lists are sorted by several threads
+    template <class Compare>
+    void sortBy(Compare less);
+    template <class Compare>
+    void stableSortBy(Compare less);
+
+    // writeTo(os, item2str, maxItems): stream the list as toString() does, chunk by chunk;
+    //      at most maxItems items are written (-1: all), the rest is shown as "..."
+    void writeTo(ostream &os, string (*item2str)(T &) = 0, int maxItems = -1);
+
+    // Persistence, for trivially copyable T (file format: ListFile.h);
+    //      I/O errors and foreign files throw std::runtime_error
+    // save(path): write the items to "path"
+    void save(const string &path);
+    // load(path): replace the items with the ones saved in "path"
+    void load(const string &path);
+    // mapFile(path): replace the items with the ones saved in "path", served straight from a
+    //      private mapping of the file: nothing is copied up front, pages are read on first
+    //      touch and changes never reach the file; growing moves the items to regular storage
+    void mapFile(const string &path);
+    // isMapped(): true while the items live in a file mapping
+    bool isMapped()
+    {
+        return mapping.base != 0;
+    }
+
     void println(string (*item2str)(T &) = 0)
     {
-        cout << toString(item2str) << endl;
+        writeTo(cout, item2str);
+        cout << endl;
     }
-    void setDeleteUserDataPtr(void (*deleteUserData)(XArrayList<T> *) = 0)
+    void setDeleteUserDataPtr(void (*deleteUserData)(XArrayList<T, Alloc, Growth, Equal, Formatter> *) = 0)
     {
         this->deleteUserData = deleteUserData;
     }
 
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
     Iterator begin()
     {
+        detach();
         return Iterator(this, 0);
     }
     Iterator end()
     {
+        detach();
         return Iterator(this, count);
     }
+    ConstIterator begin() const
+    {
+        return ConstIterator(this, 0);
+    }
+    ConstIterator end() const
+    {
+        return ConstIterator(this, count);
+    }
+    ConstIterator cbegin() const
+    {
+        return ConstIterator(this, 0);
+    }
+    ConstIterator cend() const
+    {
+        return ConstIterator(this, count);
+    }
+    // rawData(): the contiguous buffer behind the list, [rawData(), rawData() + size());
+    //      for algorithms that want plain pointers; invalidated by any reallocation
+    T *rawData()
+    {
+        detach();
+        return data;
+    }
+    const T *rawData() const
+    {
+        return data;
+    }
 
-    static void free(XArrayList<T> *list)
+    static void free(XArrayList<T, Alloc, Growth, Equal, Formatter> *list)
     {
-        typename XArrayList<T>::Iterator it = list->begin();
+        typename XArrayList<T, Alloc, Growth, Equal, Formatter>::Iterator it = list->begin();
         while (it != list->end())
         {
             delete *it;
@@ -82,28 +214,80 @@ protected:
     static bool equals(T &lhs, T &rhs, bool (*itemEqual)(T &, T &))
     {
         if (itemEqual == 0)
-            return lhs == rhs;
+            return Equal()(lhs, rhs);
         else
             return itemEqual(lhs, rhs);
     }
 
-    void copyFrom(const XArrayList<T> &list);
+    void copyFrom(const XArrayList<T, Alloc, Growth, Equal, Formatter> &list);
+
+    // cowType: buffers can be shared, since any allocator object can free what another one allocated
+    static const bool cowType = AllocTraits::is_always_equal::value;
+    // shared(): true while other lists use the same buffer
+    bool shared() const
+    {
+        return refs != 0 && refs->load(std::memory_order_acquire) > 1;
+    }
+    // detach(): give this list its own copy of a shared buffer, before changing it
+    void detach()
+    {
+        if (shared())
+            unshare(true);
+    }
+    void unshare(bool copyItems);
+    // shareFrom(list): take (a share of) the items of "list"; this list holds no buffer
+    void shareFrom(const XArrayList<T, Alloc, Growth, Equal, Formatter> &list);
+    // stealFrom(list): take over the buffer of "list", leaving it empty; this list holds no buffer
+    void stealFrom(XArrayList<T, Alloc, Growth, Equal, Formatter> &list);
+    // releaseData(): destroy the items and free the buffer, or only drop this list's share of it
+    void releaseData();
+
+    // simdScanType: items compare with a plain operator== the kernels of ListSimd.h can vectorize
+    static const bool simdScanType = XSimdOps<T>::supported && std::is_same<Equal, XEqual<T>>::value;
+
+    // raw storage: allocate/deallocate never construct or destroy items
+    T *allocate(int n);
+    void deallocate(T *ptr, int n);
+    void destroyItems(T *ptr, int n);
+    // copyItems/relocateItems: fill the raw storage at dst from src (no overlap);
+    // relocateItems also destroys the source items
+    void copyItems(T *dst, const T *src, int n);
+    void relocateItems(T *dst, T *src, int n);
+    // moveItems: move-assign n constructed items from src to dst (ranges may overlap);
+    // trivially copyable items are moved with a single memmove
+    static void moveItems(T *dst, T *src, int n);
+    // openGap: shift [index, count) right by n, leaving slots [index, index + n) raw
+    void openGap(int index, int n = 1);
+    void grow(int minCapacity);
+    void reallocate(int newCapacity);
 
     void removeInternalData();
+    // scanFor(item): location of the first item equal to "item", -1 if none
+    int scanFor(T &item);
 
     //////////////////////////////////////////////////////////////////////
     ////////////////////////  INNER CLASSES DEFNITION ////////////////////
     //////////////////////////////////////////////////////////////////////
 public:
     // Iterator: BEGIN
+    // Iterator, ConstIterator: random-access iterators over the array, so the
+    // standard algorithms (std::sort, std::lower_bound, ...) run in place;
+    // they hold a location rather than a pointer, so they stay valid across reallocation
     class Iterator
     {
     private:
         int cursor;
-        XArrayList<T> *pList;
+        XArrayList<T, Alloc, Growth, Equal, Formatter> *pList;
+        friend class ConstIterator;
 
     public:
-        Iterator(XArrayList<T> *pList = 0, int index = 0)
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T *pointer;
+        typedef T &reference;
+
+        Iterator(XArrayList<T, Alloc, Growth, Equal, Formatter> *pList = 0, int index = 0)
         {
             this->pList = pList;
             this->cursor = index;
@@ -121,15 +305,48 @@ public:
                 removeItemData(item);
             cursor -= 1; // MUST keep index of previous, for ++ later
         }
+        // base(): address of the current item, valid until the list reallocates
+        T *base() const
+        {
+            return pList->data + cursor;
+        }
 
-        T &operator*()
+        T &operator*() const
         {
             return pList->data[cursor];
         }
-        bool operator!=(const Iterator &iterator)
+        T *operator->() const
+        {
+            return pList->data + cursor;
+        }
+        T &operator[](difference_type offset) const
+        {
+            return pList->data[cursor + offset];
+        }
+        bool operator==(const Iterator &iterator) const
+        {
+            return cursor == iterator.cursor;
+        }
+        bool operator!=(const Iterator &iterator) const
         {
             return cursor != iterator.cursor;
         }
+        bool operator<(const Iterator &iterator) const
+        {
+            return cursor < iterator.cursor;
+        }
+        bool operator>(const Iterator &iterator) const
+        {
+            return cursor > iterator.cursor;
+        }
+        bool operator<=(const Iterator &iterator) const
+        {
+            return cursor <= iterator.cursor;
+        }
+        bool operator>=(const Iterator &iterator) const
+        {
+            return cursor >= iterator.cursor;
+        }
         // Prefix ++ overload
         Iterator &operator++()
         {
@@ -143,6 +360,157 @@ public:
             ++*this;
             return iterator;
         }
+        Iterator &operator--()
+        {
+            this->cursor--;
+            return *this;
+        }
+        Iterator operator--(int)
+        {
+            Iterator iterator = *this;
+            --*this;
+            return iterator;
+        }
+        Iterator &operator+=(difference_type offset)
+        {
+            cursor += offset;
+            return *this;
+        }
+        Iterator &operator-=(difference_type offset)
+        {
+            cursor -= offset;
+            return *this;
+        }
+        Iterator operator+(difference_type offset) const
+        {
+            return Iterator(pList, cursor + offset);
+        }
+        Iterator operator-(difference_type offset) const
+        {
+            return Iterator(pList, cursor - offset);
+        }
+        difference_type operator-(const Iterator &iterator) const
+        {
+            return cursor - iterator.cursor;
+        }
+        friend Iterator operator+(difference_type offset, const Iterator &iterator)
+        {
+            return iterator + offset;
+        }
+    };
+
+    class ConstIterator
+    {
+    private:
+        int cursor;
+        const XArrayList<T, Alloc, Growth, Equal, Formatter> *pList;
+
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        ConstIterator(const XArrayList<T, Alloc, Growth, Equal, Formatter> *pList = 0, int index = 0)
+        {
+            this->pList = pList;
+            this->cursor = index;
+        }
+        ConstIterator(const Iterator &iterator)
+        {
+            this->pList = iterator.pList;
+            this->cursor = iterator.cursor;
+        }
+        const T *base() const
+        {
+            return pList->data + cursor;
+        }
+
+        const T &operator*() const
+        {
+            return pList->data[cursor];
+        }
+        const T *operator->() const
+        {
+            return pList->data + cursor;
+        }
+        const T &operator[](difference_type offset) const
+        {
+            return pList->data[cursor + offset];
+        }
+        bool operator==(const ConstIterator &iterator) const
+        {
+            return cursor == iterator.cursor;
+        }
+        bool operator!=(const ConstIterator &iterator) const
+        {
+            return cursor != iterator.cursor;
+        }
+        bool operator<(const ConstIterator &iterator) const
+        {
+            return cursor < iterator.cursor;
+        }
+        bool operator>(const ConstIterator &iterator) const
+        {
+            return cursor > iterator.cursor;
+        }
+        bool operator<=(const ConstIterator &iterator) const
+        {
+            return cursor <= iterator.cursor;
+        }
+        bool operator>=(const ConstIterator &iterator) const
+        {
+            return cursor >= iterator.cursor;
+        }
+        ConstIterator &operator++()
+        {
+            this->cursor++;
+            return *this;
+        }
+        ConstIterator operator++(int)
+        {
+            ConstIterator iterator = *this;
+            ++*this;
+            return iterator;
+        }
+        ConstIterator &operator--()
+        {
+            this->cursor--;
+            return *this;
+        }
+        ConstIterator operator--(int)
+        {
+            ConstIterator iterator = *this;
+            --*this;
+            return iterator;
+        }
+        ConstIterator &operator+=(difference_type offset)
+        {
+            cursor += offset;
+            return *this;
+        }
+        ConstIterator &operator-=(difference_type offset)
+        {
+            cursor -= offset;
+            return *this;
+        }
+        ConstIterator operator+(difference_type offset) const
+        {
+            return ConstIterator(pList, cursor + offset);
+        }
+        ConstIterator operator-(difference_type offset) const
+        {
+            return ConstIterator(pList, cursor - offset);
+        }
+        difference_type operator-(const ConstIterator &iterator) const
+        {
+            return cursor - iterator.cursor;
+        }
+        friend ConstIterator operator+(difference_type offset, const ConstIterator &iterator)
+        {
+            return iterator + offset;
+        }
     };
     // Iterator: END
 };
@@ -151,9 +519,9 @@ public:
 ////////////////////////     METHOD DEFNITION      ///////////////////
 //////////////////////////////////////////////////////////////////////
 
-template <class T>
-XArrayList<T>::XArrayList(
-    void (*deleteUserData)(XArrayList<T> *),
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+XArrayList<T, Alloc, Growth, Equal, Formatter>::XArrayList(
+    void (*deleteUserData)(XArrayList<T, Alloc, Growth, Equal, Formatter> *),
     bool (*itemEqual)(T &, T &),
     int capacity)
 {
@@ -161,173 +529,199 @@ XArrayList<T>::XArrayList(
     this->itemEqual = itemEqual;
     this->capacity = capacity;
     this->count = 0;
-    data = new T[capacity];
+    this->mapping = XListMapping{0, 0};
+    this->refs = cowType ? new std::atomic<int>(1) : 0;
+    data = allocate(capacity);
 }
 
-template <class T>
-void XArrayList<T>::copyFrom(const XArrayList<T> &list)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::copyFrom(const XArrayList<T, Alloc, Growth, Equal, Formatter> &list)
 {
     this->removeInternalData();
 
-    capacity = list.capacity;
-    count = list.count;
     itemEqual = list.itemEqual;
     deleteUserData = list.deleteUserData;
-
-    data = new T[capacity];
-
-    for (int i = 0; i < count; i++)
-    {
-        data[i] = list.data[i];
-    }
+    shareFrom(list);
 }
 
-template <class T>
-void XArrayList<T>::removeInternalData()
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::removeInternalData()
 {
     if (deleteUserData)
     {
         deleteUserData(this);
     }
-
-    delete[] data;
-    data = nullptr;
-
-    count = 0;
-    capacity = 0;
+    releaseData();
 }
 
-template <class T>
-XArrayList<T>::XArrayList(const XArrayList<T> &list)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+XArrayList<T, Alloc, Growth, Equal, Formatter>::XArrayList(const XArrayList<T, Alloc, Growth, Equal, Formatter> &list)
+    : alloc(AllocTraits::select_on_container_copy_construction(list.alloc))
 {
-    capacity = list.capacity;
-    count = list.count;
+    mapping = XListMapping{0, 0};
+    refs = 0;
     itemEqual = list.itemEqual;
     deleteUserData = list.deleteUserData;
+    shareFrom(list);
+}
 
-    data = new T[capacity];
-    for (int i = 0; i < count; i++)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+XArrayList<T, Alloc, Growth, Equal, Formatter> &XArrayList<T, Alloc, Growth, Equal, Formatter>::operator=(const XArrayList<T, Alloc, Growth, Equal, Formatter> &list)
+{
+    if (this != &list)
     {
-        data[i] = list.data[i];
+        releaseData();
+        itemEqual = list.itemEqual;
+        deleteUserData = list.deleteUserData;
+        shareFrom(list);
     }
+    return *this;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+XArrayList<T, Alloc, Growth, Equal, Formatter>::XArrayList(XArrayList<T, Alloc, Growth, Equal, Formatter> &&list) noexcept(cowType)
+    : alloc(std::move(list.alloc))
+{
+    data = nullptr;
+    capacity = 0;
+    count = 0;
+    mapping = XListMapping{0, 0};
+    refs = 0;
+    itemEqual = list.itemEqual;
+    deleteUserData = list.deleteUserData;
+    stealFrom(list);
 }
 
-template <class T>
-XArrayList<T> &XArrayList<T>::operator=(const XArrayList<T> &list)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+XArrayList<T, Alloc, Growth, Equal, Formatter> &XArrayList<T, Alloc, Growth, Equal, Formatter>::operator=(XArrayList<T, Alloc, Growth, Equal, Formatter> &&list) noexcept(cowType)
 {
     if (this != &list)
     {
-        delete[] data;
-        capacity = list.capacity;
-        count = list.count;
+        releaseData();
         itemEqual = list.itemEqual;
         deleteUserData = list.deleteUserData;
-        data = new T[capacity];
-        for (int i = 0; i < count; ++i)
-        {
-            data[i] = list.data[i];
-        }
+        stealFrom(list);
     }
     return *this;
 }
 
-template <class T>
-XArrayList<T>::~XArrayList()
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+XArrayList<T, Alloc, Growth, Equal, Formatter>::~XArrayList()
 {
     if (deleteUserData)
     {
         deleteUserData(this);
     }
-    delete[] data;
+    releaseData();
+    delete refs;
 }
 
-template <class T>
-void XArrayList<T>::add(T e)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::add(T e)
 {
+    detach();
     if (count == capacity)
     {
-        capacity = capacity * 2;
-        T *newData = new T[capacity];
-        for (int i = 0; i < count; i++)
-        {
-            newData[i] = data[i];
-        }
-        delete[] data;
-        data = newData;
+        grow(count + 1);
     }
-    data[count] = e;
+    AllocTraits::construct(alloc, data + count, std::move(e));
+    XLIST_STAT(XArrayList, moves, 1);
     count++;
 }
 
-template <class T>
-void XArrayList<T>::add(int index, T e)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::add(int index, T e)
 {
+    detach();
     if (index < 0 || index > count)
     {
         throw out_of_range("Index is out of range!");
     }
     if (count == capacity)
     {
-        capacity = capacity * 2;
-        T *newData = new T[capacity];
-        for (int i = 0; i < count; i++)
-        {
-            newData[i] = data[i];
-        }
-        delete[] data;
-        data = newData;
+        grow(count + 1);
     }
-    for (int i = count; i > index; i--)
+    openGap(index);
+    AllocTraits::construct(alloc, data + index, std::move(e));
+    XLIST_STAT(XArrayList, moves, 1);
+    count++;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+template <class... Args>
+T &XArrayList<T, Alloc, Growth, Equal, Formatter>::emplace_back(Args &&...args)
+{
+    detach();
+    if (count == capacity)
     {
-        data[i] = data[i - 1];
+        // args may refer to an item of this list: build it before the buffer moves
+        T item(std::forward<Args>(args)...);
+        grow(count + 1);
+        AllocTraits::construct(alloc, data + count, std::move(item));
     }
-    data[index] = e;
-    count++;
+    else
+    {
+        AllocTraits::construct(alloc, data + count, std::forward<Args>(args)...);
+    }
+    return data[count++];
 }
 
-template <class T>
-T XArrayList<T>::removeAt(int index)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+template <class... Args>
+T &XArrayList<T, Alloc, Growth, Equal, Formatter>::emplace(int index, Args &&...args)
 {
-    if (index < 0 || index >= count)
+    detach();
+    if (index < 0 || index > count)
     {
         throw out_of_range("Index is out of range!");
     }
-    T removedData = data[index];
-    for (int i = index; i < count - 1; i++)
+    if (index == count)
+    {
+        return emplace_back(std::forward<Args>(args)...);
+    }
+    // args may refer to an item that the shift below is about to move
+    T item(std::forward<Args>(args)...);
+    if (count == capacity)
     {
-        data[i] = data[i + 1];
+        grow(count + 1);
     }
+    openGap(index);
+    AllocTraits::construct(alloc, data + index, std::move(item));
+    count++;
+    return data[index];
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+T XArrayList<T, Alloc, Growth, Equal, Formatter>::removeAt(int index)
+{
+    detach();
+    if (index < 0 || index >= count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    XLIST_STAT(XArrayList, removes, 1);
+    XLIST_STAT(XArrayList, removeSteps, count - index - 1);
+    T removedData = std::move(data[index]);
+    moveItems(data + index, data + index + 1, count - index - 1);
+    AllocTraits::destroy(alloc, data + count - 1);
     count--;
     return removedData;
 }
 
-template <class T>
-bool XArrayList<T>::removeItem(T item, void (*removeItemData)(T))
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+bool XArrayList<T, Alloc, Growth, Equal, Formatter>::removeItem(T item, void (*removeItemData)(T))
 {
-
-    for (int i = 0; i < count; i++)
+    int index = indexOf(item);
+    if (index == -1)
     {
-        // if(data[i] == item){
-        //     if (removeItemData != nullptr) {
-        //         removeItemData(data[i]);
-        //     } else {
-        //         removeAt(i);
-
-        //         return true;
-        //     }
-        // }
-
-        if (equals(data[i], item, itemEqual))
-        {
-            removeAt(i);
-            return true;
-        }
+        return false;
     }
-    return false;
+    removeAt(index);
+    return true;
 }
 
-template <class T>
-bool XArrayList<T>::empty()
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+bool XArrayList<T, Alloc, Growth, Equal, Formatter>::empty()
 {
     if (count == 0)
     {
@@ -339,48 +733,265 @@ bool XArrayList<T>::empty()
     }
 }
 
-template <class T>
-int XArrayList<T>::size()
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+int XArrayList<T, Alloc, Growth, Equal, Formatter>::size()
 {
     return count;
 }
 
-template <class T>
-void XArrayList<T>::clear()
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::forEachItem(void (*visit)(const T &, void *), void *context)
 {
-    delete[] data;
-    count = 0;
-    capacity = 10;
-    data = new T[capacity];
+    // reads only: a buffer shared copy-on-write stays shared
+    for (int i = 0; i < count; i++)
+        visit(data[i], context);
 }
 
-template <class T>
-T &XArrayList<T>::get(int index)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::addAll(const T *items, int n)
 {
+    insertRange(count, items, items + n);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::addAll(IList<T> &list)
+{
+    XArrayList<T, Alloc, Growth, Equal, Formatter> *pArray = dynamic_cast<XArrayList<T, Alloc, Growth, Equal, Formatter> *>(&list);
+    if (pArray != 0)
+    {
+        insertRange(count, pArray->data, pArray->data + pArray->count);
+        return;
+    }
+    int n = list.size();
+    reserve(count + n);
+    for (int idx = 0; idx < n; idx++)
+    {
+        add(list.get(idx));
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::insertRange(int index, const T *first, const T *last)
+{
+    detach();
+    if (index < 0 || index > count)
+    {
+        throw out_of_range("Index is out of range!");
+    }
+    int n = last - first;
+    if (n <= 0)
+        return;
+    std::less<const T *> before;
+    if (!before(first, data) && before(first, data + count))
+    {
+        // the range lives in this list: take a copy before the buffer moves
+        XArrayList<T, Alloc, Growth, Equal, Formatter> items(0, 0, n);
+        items.copyItems(items.data, first, n);
+        items.count = n;
+        insertRange(index, items.data, items.data + n);
+        return;
+    }
+    if (count + n > capacity)
+    {
+        grow(count + n);
+    }
+    openGap(index, n);
+    copyItems(data + index, first, n);
+    count += n;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::removeRange(int from, int to)
+{
+    detach();
+    if (from < 0 || to > count || from > to)
+    {
+        throw out_of_range("Range is out of range!");
+    }
+    int n = to - from;
+    if (n == 0)
+        return;
+    moveItems(data + from, data + to, count - to);
+    destroyItems(data + count - n, n);
+    count -= n;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::clear()
+{
+    clear(true);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::clear(bool keepCapacity)
+{
+    if (shared())
+    {
+        // the other lists keep the items: start over in a buffer of our own
+        unshare(false);
+    }
+    else
+    {
+        destroyItems(data, count);
+        count = 0;
+    }
+    if (!keepCapacity)
+    {
+        deallocate(data, capacity);
+        capacity = 10;
+        data = allocate(capacity);
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::reserve(int n)
+{
+    detach();
+    if (n > capacity)
+    {
+        reallocate(n);
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::shrink_to_fit()
+{
+    detach();
+    if (capacity > count)
+    {
+        reallocate(count);
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::sort(bool (*comparator)(T &, T &))
+{
+    detach();
+    xsortRange(data, data + count, comparator, false);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::stableSort(bool (*comparator)(T &, T &))
+{
+    detach();
+    xsortRange(data, data + count, comparator, true);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+template <class Compare>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::sortBy(Compare less)
+{
+    detach();
+    xsortBy(data, data + count, less, false);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+template <class Compare>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::stableSortBy(Compare less)
+{
+    detach();
+    xsortBy(data, data + count, less, true);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::save(const string &path)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "save() needs trivially copyable items");
+    xlistWriteFile(path, data, sizeof(T), count);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::load(const string &path)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "load() needs trivially copyable items");
+    int n;
+    FILE *file = xlistOpenFile(path, sizeof(T), n);
+    try
+    {
+        clear(true);
+        if (n > capacity || isMapped())
+        {
+            deallocate(data, capacity);
+            data = nullptr;
+            capacity = 0;
+            data = allocate(n);
+            capacity = n;
+        }
+    }
+    catch (...)
+    {
+        fclose(file);
+        throw;
+    }
+    xlistReadItems(file, path, data, sizeof(T), n);
+    count = n;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::mapFile(const string &path)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "mapFile() needs trivially copyable items");
+#ifdef XLIST_HAVE_MMAP
+    int n;
+    XListMapping newMapping = xlistMapFile(path, sizeof(T), n);
+    releaseData();
+    mapping = newMapping;
+    data = reinterpret_cast<T *>(static_cast<char *>(mapping.base) + sizeof(XListFileHeader));
+    capacity = n;
+    count = n;
+#else
+    load(path); // no mmap on this platform: read the file instead
+#endif
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+T &XArrayList<T, Alloc, Growth, Equal, Formatter>::get(int index)
+{
+    detach();
     if (index < 0 || index >= count)
     {
         throw std::out_of_range("Index is out of range!");
     }
+    XLIST_STAT(XArrayList, gets, 1);
     return data[index];
 }
 
-template <class T>
-int XArrayList<T>::indexOf(T item)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+int XArrayList<T, Alloc, Growth, Equal, Formatter>::indexOf(T item)
 {
-    for (int i = 0; i < count; i++)
+    int found = scanFor(item);
+    XLIST_STAT(XArrayList, indexOfs, 1);
+    XLIST_STAT(XArrayList, indexOfScanned, found == -1 ? count : found + 1);
+    return found;
+}
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+int XArrayList<T, Alloc, Growth, Equal, Formatter>::scanFor(T &item)
+{
+    if constexpr (simdScanType)
     {
-        // if(data[i] == item){
-        //     return i;
-        // }
-        if (equals(data[i], item, itemEqual))
+        if (itemEqual == 0)
+            return xsimdFind(data, count, item);
+    }
+    // test the function pointer once, so the default scan can be inlined
+    if (itemEqual != 0)
+    {
+        for (int i = 0; i < count; i++)
         {
-            return i;
+            if (itemEqual(data[i], item))
+                return i;
         }
+        return -1;
+    }
+    Equal equal;
+    for (int i = 0; i < count; i++)
+    {
+        if (equal(data[i], item))
+            return i;
     }
     return -1;
 }
-template <class T>
-bool XArrayList<T>::contains(T item)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+bool XArrayList<T, Alloc, Growth, Equal, Formatter>::contains(T item)
 {
     if (indexOf(item) != -1)
     {
@@ -392,43 +1003,117 @@ bool XArrayList<T>::contains(T item)
     }
 }
 
-template <class T>
-string XArrayList<T>::toString(string (*item2str)(T &))
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+int XArrayList<T, Alloc, Growth, Equal, Formatter>::countOf(T item)
 {
-    stringstream ss;
-    ss << "[";
+    if constexpr (simdScanType)
+    {
+        if (itemEqual == 0)
+            return xsimdCount(data, count, item);
+    }
+    int found = 0;
     for (int i = 0; i < count; i++)
     {
-        if (i > 0)
-        {
-            ss << ", ";
-        }
-        if (item2str != nullptr)
-        {
-            ss << item2str(data[i]);
-        }
-        else
+        if (equals(data[i], item, itemEqual))
+            found++;
+    }
+    return found;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+XArrayList<int> XArrayList<T, Alloc, Growth, Equal, Formatter>::findAll(T item)
+{
+    XArrayList<int> found;
+    if constexpr (simdScanType)
+    {
+        if (itemEqual == 0)
         {
-            ss << data[i];
+            int from = 0;
+            while (from < count)
+            {
+                int next = xsimdFind(data + from, count - from, item);
+                if (next == -1)
+                    break;
+                found.add(from + next);
+                from += next + 1;
+            }
+            return found;
         }
     }
-    ss << "]";
+    for (int i = 0; i < count; i++)
+    {
+        if (equals(data[i], item, itemEqual))
+            found.add(i);
+    }
+    return found;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+T XArrayList<T, Alloc, Growth, Equal, Formatter>::min()
+{
+    int at = argmin();
+    if (at < 0 || at >= count)
+    {
+        throw out_of_range("List is empty!");
+    }
+    return data[at];
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+T XArrayList<T, Alloc, Growth, Equal, Formatter>::max()
+{
+    int at = argmax();
+    if (at < 0 || at >= count)
+    {
+        throw out_of_range("List is empty!");
+    }
+    return data[at];
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+int XArrayList<T, Alloc, Growth, Equal, Formatter>::argmin()
+{
+    return xsimdArgExtreme(data, count, false);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+int XArrayList<T, Alloc, Growth, Equal, Formatter>::argmax()
+{
+    return xsimdArgExtreme(data, count, true);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+string XArrayList<T, Alloc, Growth, Equal, Formatter>::toString(string (*item2str)(T &))
+{
+    stringstream ss;
+    writeTo(ss, item2str);
     return ss.str();
 }
 
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::writeTo(ostream &os, string (*item2str)(T &), int maxItems)
+{
+    XListWriter<T, Formatter> writer(os, item2str, maxItems);
+    for (int i = 0; i < count && !writer.full(); i++)
+    {
+        writer.item(data[i]);
+    }
+    writer.finish(count);
+}
+
 //////////////////////////////////////////////////////////////////////
 //////////////////////// (private) METHOD DEFNITION //////////////////
 //////////////////////////////////////////////////////////////////////
-template <class T>
-void XArrayList<T>::checkIndex(int index)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::checkIndex(int index)
 {
     if (index < 0 || index >= count)
     {
         throw out_of_range("Index is out of range!");
     }
 }
-template <class T>
-void XArrayList<T>::ensureCapacity(int index)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::ensureCapacity(int index)
 {
     if (index < 0)
     {
@@ -436,22 +1121,251 @@ void XArrayList<T>::ensureCapacity(int index)
     }
     if (index >= capacity)
     {
-        int newCapacity = capacity;
-        while (newCapacity <= index)
-        {
-            newCapacity = newCapacity * 2;
-        }
-        T *newData = new T[newCapacity];
+        grow(index + 1);
+    }
+}
 
-        for (int i = 0; i < count; i++)
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::grow(int minCapacity)
+{
+    int newCapacity = capacity > 0 ? capacity : 1;
+    while (newCapacity < minCapacity)
+    {
+        int next = Growth::next(newCapacity);
+        newCapacity = next > newCapacity ? next : newCapacity + 1;
+    }
+    reallocate(newCapacity);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::reallocate(int newCapacity)
+{
+    XLIST_STAT(XArrayList, reallocations, 1);
+    T *newData = allocate(newCapacity);
+    relocateItems(newData, data, count);
+    deallocate(data, capacity);
+
+    data = newData;
+    capacity = newCapacity;
+    if (cowType && refs == 0)
+    {
+        // first buffer of a moved-from list
+        refs = new std::atomic<int>(1);
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::unshare(bool keepItems)
+{
+    T *own = allocate(capacity);
+    int n = keepItems ? count : 0;
+    copyItems(own, data, n);
+    if (refs->fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // the other lists let go of the buffer meanwhile
+        refs->store(1, std::memory_order_relaxed);
+        destroyItems(data, count);
+        deallocate(data, capacity);
+    }
+    else
+    {
+        refs = new std::atomic<int>(1);
+    }
+    data = own;
+    count = n;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::shareFrom(const XArrayList<T, Alloc, Growth, Equal, Formatter> &list)
+{
+    capacity = list.capacity;
+    count = list.count;
+    if (list.refs != 0 && list.mapping.base == 0)
+    {
+        delete refs;
+        refs = list.refs;
+        refs->fetch_add(1, std::memory_order_relaxed);
+        data = list.data;
+    }
+    else
+    {
+        if (cowType && refs == 0)
+            refs = new std::atomic<int>(1);
+        data = allocate(capacity);
+        copyItems(data, list.data, count);
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::stealFrom(XArrayList<T, Alloc, Growth, Equal, Formatter> &list)
+{
+    // a heap buffer of an allocator with inline storage can be taken over like any other
+    bool heapBuffer = false;
+    if constexpr (XAllocOwns<Alloc>::value)
+        heapBuffer = list.data != nullptr && !list.alloc.owns(list.data);
+    if (cowType || list.mapping.base != 0 || heapBuffer)
+    {
+        delete refs;
+        data = list.data;
+        capacity = list.capacity;
+        count = list.count;
+        refs = list.refs;
+        mapping = list.mapping;
+        list.data = nullptr;
+        list.capacity = 0;
+        list.count = 0;
+        list.refs = 0;
+        list.mapping = XListMapping{0, 0};
+    }
+    else
+    {
+        // the buffer belongs to the allocator of "list" (its inline storage): move the items over
+        capacity = list.capacity;
+        data = allocate(capacity);
+        relocateItems(data, list.data, list.count);
+        count = list.count;
+        list.count = 0;
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::releaseData()
+{
+    if (refs != 0 && refs->fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        // the other lists keep the buffer
+        refs = 0;
+    }
+    else
+    {
+        if (refs != 0)
+            refs->store(1, std::memory_order_relaxed);
+        destroyItems(data, count);
+        deallocate(data, capacity);
+    }
+    data = nullptr;
+    count = 0;
+    capacity = 0;
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::moveItems(T *dst, T *src, int n)
+{
+    if (n <= 0 || dst == src)
+        return;
+    XLIST_STAT(XArrayList, moves, n);
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        memmove(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(T));
+    }
+    else if (dst < src)
+    {
+        for (int i = 0; i < n; i++)
+            dst[i] = std::move(src[i]);
+    }
+    else
+    {
+        for (int i = n - 1; i >= 0; i--)
+            dst[i] = std::move(src[i]);
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::openGap(int index, int n)
+{
+    if (index == count || n <= 0)
+        return;
+    XLIST_STAT(XArrayList, moves, count - index);
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        memmove(static_cast<void *>(data + index + n), static_cast<const void *>(data + index),
+                (count - index) * sizeof(T));
+    }
+    else
+    {
+        // back to front: items landing past "count" go to raw slots, the others overwrite moved-from items
+        for (int i = count - 1; i >= index; i--)
         {
-            newData[i] = data[i];
+            if (i + n >= count)
+                AllocTraits::construct(alloc, data + i + n, std::move(data[i]));
+            else
+                data[i + n] = std::move(data[i]);
         }
+        int gapEnd = index + n < count ? index + n : count;
+        destroyItems(data + index, gapEnd - index);
+    }
+}
 
-        delete[] data;
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+T *XArrayList<T, Alloc, Growth, Equal, Formatter>::allocate(int n)
+{
+    if (n <= 0)
+        return nullptr;
+    XLIST_STAT(XArrayList, allocations, 1);
+    XLIST_STAT(XArrayList, bytes, (long long)n * sizeof(T));
+    return AllocTraits::allocate(alloc, n);
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::deallocate(T *ptr, int n)
+{
+    if (ptr == nullptr)
+        return;
+#ifdef XLIST_HAVE_MMAP
+    if (mapping.base != 0 && static_cast<void *>(ptr) == static_cast<char *>(mapping.base) + sizeof(XListFileHeader))
+    {
+        xlistUnmap(mapping);
+        return;
+    }
+#endif
+    XLIST_STAT(XArrayList, frees, 1);
+    AllocTraits::deallocate(alloc, ptr, n);
+}
 
-        data = newData;
-        capacity = newCapacity;
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::destroyItems(T *ptr, int n)
+{
+    if constexpr (!std::is_trivially_destructible<T>::value)
+    {
+        for (int i = 0; i < n; i++)
+            AllocTraits::destroy(alloc, ptr + i);
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::copyItems(T *dst, const T *src, int n)
+{
+    if (n <= 0)
+        return;
+    XLIST_STAT(XArrayList, copies, n);
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        memcpy(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(T));
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+            AllocTraits::construct(alloc, dst + i, src[i]);
+    }
+}
+
+template <class T, class Alloc, class Growth, class Equal, class Formatter>
+void XArrayList<T, Alloc, Growth, Equal, Formatter>::relocateItems(T *dst, T *src, int n)
+{
+    if (n <= 0)
+        return;
+    XLIST_STAT(XArrayList, moves, n);
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        memcpy(static_cast<void *>(dst), static_cast<const void *>(src), n * sizeof(T));
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+        {
+            AllocTraits::construct(alloc, dst + i, std::move(src[i]));
+            AllocTraits::destroy(alloc, src + i);
+        }
     }
 }
 
@@ -0,0 +1,121 @@
+/*
+ * File:   XSmallList.h
+ *
+ * XSmallList<T, N>: an XArrayList that keeps up to N items inside the list
+ * object itself and only moves them to the heap once it grows past N.
+ * Creating, filling (up to N items) and destroying a small list does no heap
+ * allocation at all.
+ *
+ * The inline buffer is provided by XInlineAlloc<T, N>, plugged into the
+ * allocator parameter of XArrayList, so every XArrayList operation is
+ * available unchanged.
+ */
+
+#ifndef XSMALLLIST_H
+#define XSMALLLIST_H
+#include "list/XArrayList.h"
+#include <cstddef>
+#include <memory>
+using namespace std;
+
+/* XInlineAlloc<T, N>: hands out its own inline buffer for requests of at
+ * most N items while that buffer is free, and the heap otherwise.
+ * Each allocator object owns its buffer: copies start with a fresh, unused
+ * one, and two allocators only compare equal if they are the same object.
+ */
+template <class T, int N>
+class XInlineAlloc
+{
+public:
+    typedef T value_type;
+    template <class U>
+    struct rebind
+    {
+        typedef XInlineAlloc<U, N> other;
+    };
+
+    XInlineAlloc() : inUse(false) {}
+    XInlineAlloc(const XInlineAlloc<T, N> &) : inUse(false) {}
+    template <class U>
+    XInlineAlloc(const XInlineAlloc<U, N> &) : inUse(false) {}
+    XInlineAlloc<T, N> &operator=(const XInlineAlloc<T, N> &)
+    {
+        return *this;
+    }
+
+    T *allocate(size_t n)
+    {
+        if (!inUse && n <= static_cast<size_t>(N))
+        {
+            inUse = true;
+            return reinterpret_cast<T *>(buffer);
+        }
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *ptr, size_t n)
+    {
+        if (owns(ptr))
+            inUse = false;
+        else
+            std::allocator<T>().deallocate(ptr, n);
+    }
+    // owns(ptr): true if ptr is this allocator's inline buffer; any other buffer came from
+    //      std::allocator, and any XInlineAlloc can free it (a moved list takes it over)
+    bool owns(const T *ptr) const
+    {
+        return ptr == reinterpret_cast<const T *>(buffer);
+    }
+
+    bool operator==(const XInlineAlloc<T, N> &other) const
+    {
+        return this == &other;
+    }
+    bool operator!=(const XInlineAlloc<T, N> &other) const
+    {
+        return this != &other;
+    }
+
+private:
+    alignas(T) unsigned char buffer[N * sizeof(T)];
+    bool inUse;
+};
+
+template <class T, int N = 8>
+class XSmallList : public XArrayList<T, XInlineAlloc<T, N>>
+{
+public:
+    typedef XArrayList<T, XInlineAlloc<T, N>> Base;
+
+    XSmallList(
+        void (*deleteUserData)(Base *) = 0,
+        bool (*itemEqual)(T &, T &) = 0)
+        : Base(deleteUserData, itemEqual, N)
+    {
+    }
+
+    // isInline(): true while the items are still stored inside the list object
+    bool isInline()
+    {
+        return this->alloc.owns(this->data);
+    }
+    // shrink_to_fit(): move the items back inside the list object when they fit again
+    void shrink_to_fit()
+    {
+        if (isInline())
+            return;
+        if (this->count <= N)
+            this->reallocate(N);
+        else
+            Base::shrink_to_fit();
+    }
+    // clear(false) goes back to the inline buffer instead of a fresh heap one
+    using Base::clear;
+    void clear(bool keepCapacity)
+    {
+        Base::clear(true);
+        if (!keepCapacity)
+            shrink_to_fit();
+    }
+};
+
+#endif /* XSMALLLIST_H */
@@ -15,6 +15,13 @@
 
 #include "XArrayList.h"
 #include "DLinkedList.h"
+#include "UnrolledLinkedList.h"
+#include "IndexedArrayList.h"
+#include "XArrayDeque.h"
+#include "XSmallList.h"
+#include "ConcurrentArrayList.h"
+#include "ConcurrentLinkedList.h"
+#include "PersistentList.h"
 //#include "SLinkedList.h"
 template<class T>
 using xvector = XArrayList<T>;
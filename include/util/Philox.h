@@ -0,0 +1,160 @@
+/*
+ * File:   Philox.h
+ *
+ * Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"),
+ * a counter-based random generator: block b of the stream of seed s is a pure
+ * function of (b, s), so any part of the stream can be generated without
+ * generating what comes before it. Value i of the stream is word i % 4 of
+ * block i / 4.
+ *
+ * philoxUniform(out, first, n, seed, minValue, maxValue) writes values
+ * [first, first + n) of the stream as floats in [minValue, maxValue]: the
+ * same floats whatever pieces the stream is cut into, with or without AVX2,
+ * so threads can fill disjoint parts of one buffer and get the same result as
+ * a single thread.
+ */
+
+#ifndef PHILOX_H
+#define PHILOX_H
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+class Philox
+{
+public:
+    static const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57; // round multipliers
+    static const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85; // key increments
+    static const int ROUNDS = 10;
+
+    // block(counter, key, out): out = Philox4x32-10(counter, key)
+    static void block(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+    {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < ROUNDS; round++)
+        {
+            uint64_t p0 = (uint64_t)M0 * c0, p1 = (uint64_t)M1 * c2;
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c0 = n0;
+            c1 = (uint32_t)p1;
+            c2 = n2;
+            c3 = (uint32_t)p0;
+            k0 += W0;
+            k1 += W1;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    // toUniform(bits, minValue, range): the top 24 bits of "bits" as a float in [minValue, minValue + range];
+    //      computed in double, where the product is exact, so every path rounds identically
+    static float toUniform(uint32_t bits, double minValue, double range)
+    {
+        return (float)(minValue + range * ((double)(bits >> 8) * (1.0 / 16777216.0)));
+    }
+
+#if defined(__AVX2__)
+    // block8(b0, b1, key, out): blocks b1:b0 + 0..7 (64-bit counters, words 2 and 3 zero), transposed to stream order
+    static void block8(uint32_t b0, uint32_t b1, const uint32_t key[2], __m256i out[4])
+    {
+        const __m256i m0 = _mm256_set1_epi64x(M0), m1 = _mm256_set1_epi64x(M1);
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i low = _mm256_add_epi32(_mm256_set1_epi32((int)b0), lanes);
+        // carry into the high word where the low word wrapped around
+        __m256i wrapped = _mm256_cmpgt_epi32(_mm256_xor_si256(lanes, _mm256_set1_epi32(INT32_MIN)),
+                                             _mm256_xor_si256(low, _mm256_set1_epi32(INT32_MIN)));
+        __m256i c0 = low;
+        __m256i c1 = _mm256_sub_epi32(_mm256_set1_epi32((int)b1), wrapped);
+        __m256i c2 = _mm256_setzero_si256(), c3 = _mm256_setzero_si256();
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < ROUNDS; round++)
+        {
+            __m256i hi0, lo0, hi1, lo1;
+            mulhilo(c0, m0, hi0, lo0);
+            mulhilo(c2, m1, hi1, lo1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32((int)k0));
+            c1 = lo1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32((int)k1));
+            c3 = lo0;
+            k0 += W0;
+            k1 += W1;
+        }
+        // 4 x 8 (word x block) to 8 x 4 (block x word)
+        __m256i t0 = _mm256_unpacklo_epi32(c0, c1), t1 = _mm256_unpackhi_epi32(c0, c1);
+        __m256i t2 = _mm256_unpacklo_epi32(c2, c3), t3 = _mm256_unpackhi_epi32(c2, c3);
+        __m256i u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+        __m256i u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+        out[0] = _mm256_permute2x128_si256(u0, u1, 0x20);
+        out[1] = _mm256_permute2x128_si256(u2, u3, 0x20);
+        out[2] = _mm256_permute2x128_si256(u0, u1, 0x31);
+        out[3] = _mm256_permute2x128_si256(u2, u3, 0x31);
+    }
+    // toUniform8(bits, minValue, range, out): toUniform of 8 lanes, stored to out[0..8)
+    static void toUniform8(__m256i bits, __m256d minValue, __m256d range, float *out)
+    {
+        const __m256d scale = _mm256_set1_pd(1.0 / 16777216.0);
+        __m256i top = _mm256_srli_epi32(bits, 8);
+        __m256d lowHalf = _mm256_cvtepi32_pd(_mm256_castsi256_si128(top));
+        __m256d highHalf = _mm256_cvtepi32_pd(_mm256_extracti128_si256(top, 1));
+        lowHalf = _mm256_add_pd(minValue, _mm256_mul_pd(range, _mm256_mul_pd(lowHalf, scale)));
+        highHalf = _mm256_add_pd(minValue, _mm256_mul_pd(range, _mm256_mul_pd(highHalf, scale)));
+        _mm_storeu_ps(out, _mm256_cvtpd_ps(lowHalf));
+        _mm_storeu_ps(out + 4, _mm256_cvtpd_ps(highHalf));
+    }
+
+private:
+    // mulhilo(a, m, hi, lo): 32 x 32 -> 64-bit products of every lane of a with m
+    static void mulhilo(__m256i a, __m256i m, __m256i &hi, __m256i &lo)
+    {
+        __m256i even = _mm256_mul_epu32(a, m);
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+        lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+        hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    }
+#endif
+};
+
+// philoxUniform(out, first, n, seed, minValue, maxValue): out[i] = value first + i of the stream of "seed"
+inline void philoxUniform(float *out, long long first, long long n, unsigned long long seed,
+                          float minValue, float maxValue)
+{
+    const uint32_t key[2] = {(uint32_t)seed, (uint32_t)(seed >> 32)};
+    const double low = minValue, range = (double)maxValue - minValue;
+    long long index = first, last = first + n;
+    uint32_t counter[4] = {0, 0, 0, 0}, words[4];
+
+    // scalar up to a block boundary (and for whatever AVX2 does not cover)
+    auto scalarUntil = [&](long long end)
+    {
+        while (index < end)
+        {
+            unsigned long long b = (unsigned long long)index >> 2;
+            counter[0] = (uint32_t)b;
+            counter[1] = (uint32_t)(b >> 32);
+            Philox::block(counter, key, words);
+            for (int word = (int)(index & 3); word < 4 && index < end; word++, index++)
+                *out++ = Philox::toUniform(words[word], low, range);
+        }
+    };
+#if defined(__AVX2__)
+    long long aligned = (index + 3) & ~3LL;
+    scalarUntil(aligned < last ? aligned : last);
+    const __m256d vLow = _mm256_set1_pd(low), vRange = _mm256_set1_pd(range);
+    __m256i blocks[4];
+    for (; index + 32 <= last; index += 32, out += 32)
+    {
+        unsigned long long b = (unsigned long long)index >> 2;
+        Philox::block8((uint32_t)b, (uint32_t)(b >> 32), key, blocks);
+        for (int j = 0; j < 4; j++)
+            Philox::toUniform8(blocks[j], vLow, vRange, out + 8 * j);
+    }
+#endif
+    scalarUntil(last);
+}
+
+#endif /* PHILOX_H */
@@ -19,6 +19,9 @@
 #include <math.h>
 #include <random>
 #include <sstream>
+#include <thread>
+#include <vector>
+#include "util/Philox.h"
 using namespace std;
 
 #define EPSILON (1E-8)
@@ -101,23 +104,51 @@ public:
         
         Point* head = new Point[size];
         
-        std::default_random_engine* engine;
-        if(manualSeed)
-            engine = new std::default_random_engine(static_cast<long unsigned int>(seedValue));
-        else
-            engine = new std::default_random_engine(static_cast<long unsigned int>(time(0)));
+        std::default_random_engine engine(manualSeed ? static_cast<long unsigned int>(seedValue)
+                                                     : static_cast<long unsigned int>(time(0)));
         uniform_real_distribution<double> dist(minValue, maxValue);
         
         //
         for(int idx=0; idx < size; idx++){
-            float x = dist(*engine);
-            float y = dist(*engine);
-            float z = dist(*engine);
+            float x = dist(engine);
+            float y = dist(engine);
+            float z = dist(engine);
             head[idx] = Point(x,y,z);
         }
-        delete engine;
         return head;
     }
+    
+    //genPointsParallel: fill head[0..size) with random points in [minValue, maxValue]^3;
+    //  point idx takes values 3*idx, 3*idx+1, 3*idx+2 of the Philox stream of seedValue
+    //  (see Philox.h), so the points are the same for any number of threads (0: all cores)
+    static void genPointsParallel(Point* head, long long size, float minValue=0, float maxValue=1,
+                                  unsigned long long seedValue=0, int threads=0){
+        parallelChunks(size, threads, [=](long long first, long long last){
+            const long long BATCH = 1024;
+            float values[3*BATCH];
+            for(long long idx=first; idx < last; idx += BATCH){
+                long long n = last - idx < BATCH ? last - idx : BATCH;
+                philoxUniform(values, 3*idx, 3*n, seedValue, minValue, maxValue);
+                for(long long k=0; k < n; k++)
+                    head[idx + k] = Point(values[3*k], values[3*k + 1], values[3*k + 2]);
+            }
+        });
+    }
+    //parallelChunks(size, threads, fill): fill(first, last) over contiguous pieces of [0, size), one per thread
+    template<class Fill>
+    static void parallelChunks(long long size, int threads, Fill fill){
+        if(threads <= 0) threads = (int)std::thread::hardware_concurrency();
+        long long maxThreads = size/65536 + 1; //at least ~64K points per thread
+        if(threads > maxThreads) threads = (int)maxThreads;
+        if(threads <= 1){
+            fill(0LL, size);
+            return;
+        }
+        vector<std::thread> workers;
+        for(int t=0; t < threads; t++)
+            workers.emplace_back(fill, size*t/threads, size*(t + 1)/threads);
+        for(std::thread& worker: workers) worker.join();
+    }
     static void println(Point* head, int size){
         stringstream os;
         os << "[";
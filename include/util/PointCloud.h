@@ -0,0 +1,512 @@
+/*
+ * File:   PointCloud.h
+ *
+ * PointCloud: points stored as a structure of arrays, x[], y[] and z[], each
+ * 32-byte aligned, instead of an array of Point objects. Whole-cloud kernels
+ * (radius, pointEQ, centroid, bounding box) stream through the three arrays
+ * with AVX when compiled with -mavx (or -march=native); otherwise they are
+ * plain loops with the same results. pointEQ agrees exactly with
+ * Point::operator==; radius with Point::radius (to the last bit unless the
+ * compiler fuses multiply-adds differently in the two).
+ *
+ * Interop without copying:
+ *      xView()/yView()/zView()     1-D xtensor views of one coordinate array
+ *      tensor()                    a 3 x n xtensor view of the cloud
+ *      PointCloud::adapt(list)     an n x 3 xtensor view of an XArrayList<Point>
+ *                                  (the points' own floats, no conversion)
+ * Converting between PointCloud and XArrayList<Point> (PointCloud(list),
+ * toList) copies, since the memory layouts differ.
+ */
+
+#ifndef POINTCLOUD_H
+#define POINTCLOUD_H
+#include "util/Point.h"
+#include "list/XArrayList.h"
+#include "xtensor/xadapt.hpp"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+class PointCloud
+{
+protected:
+    static const int ALIGN = 32;         // bytes: one AVX register
+    static const int LANES = ALIGN / 4;  // floats per register
+    float *buffer; // x in [0, stride), y in [stride, 2 * stride), z in [2 * stride, 3 * stride)
+    int stride;    // capacity, a multiple of LANES so that every array stays aligned
+    int count;
+
+public:
+    PointCloud(int capacity = 0);
+    // PointCloud(points, n), PointCloud(list): copy the points into a new cloud
+    PointCloud(const Point *points, int n);
+    PointCloud(XArrayList<Point> &list);
+    PointCloud(const PointCloud &cloud);
+    PointCloud(PointCloud &&cloud) noexcept;
+    PointCloud &operator=(const PointCloud &cloud);
+    PointCloud &operator=(PointCloud &&cloud) noexcept;
+    ~PointCloud();
+
+    void add(float x, float y, float z);
+    void add(const Point &point)
+    {
+        add(point.getX(), point.getY(), point.getZ());
+    }
+    Point get(int index) const;
+    void set(int index, const Point &point);
+    int size() const
+    {
+        return count;
+    }
+    bool empty() const
+    {
+        return count == 0;
+    }
+    void clear()
+    {
+        count = 0;
+    }
+    // reserve(n): make room for at least n points
+    void reserve(int n);
+    // toList(list): append the points to "list"
+    void toList(XArrayList<Point> &list) const;
+
+    // raw coordinate arrays, [xData(), xData() + size()), 32-byte aligned
+    float *xData() { return buffer; }
+    float *yData() { return buffer + stride; }
+    float *zData() { return buffer + 2 * (size_t)stride; }
+    const float *xData() const { return buffer; }
+    const float *yData() const { return buffer + stride; }
+    const float *zData() const { return buffer + 2 * (size_t)stride; }
+
+    // genPoints(size, ...): a cloud of random points, drawn exactly as Point::genPoints draws them
+    static PointCloud genPoints(int size, float minValue = 0, float maxValue = 1,
+                                bool manualSeed = false, int seedValue = 0);
+    // genPointsParallel(size, ...): the points of Point::genPointsParallel, generated on "threads" threads (0: all cores)
+    static PointCloud genPointsParallel(int size, float minValue = 0, float maxValue = 1,
+                                        unsigned long long seedValue = 0, int threads = 0);
+
+    // Kernels
+    // radius(out): out[i] = radius of point i
+    void radius(float *out) const;
+    // pointEQ(point, out): out[i] = point i equals "point" (each coordinate within EPSILON); returns the number of matches
+    int pointEQ(const Point &point, bool *out) const;
+    // indexOf(point): location of the first point equal to "point", -1 if none
+    int indexOf(const Point &point) const;
+    // centroid(): mean of the points (accumulated in double); throws std::out_of_range if empty
+    Point centroid() const;
+    // boundingBox(lower, upper): smallest and largest coordinates; throws std::out_of_range if empty
+    void boundingBox(Point &lower, Point &upper) const;
+
+    // xtensor views over the cloud's arrays: valid until the cloud grows
+    auto xView()
+    {
+        return xt::adapt(xData(), (size_t)count, xt::no_ownership(), std::array<size_t, 1>{(size_t)count});
+    }
+    auto yView()
+    {
+        return xt::adapt(yData(), (size_t)count, xt::no_ownership(), std::array<size_t, 1>{(size_t)count});
+    }
+    auto zView()
+    {
+        return xt::adapt(zData(), (size_t)count, xt::no_ownership(), std::array<size_t, 1>{(size_t)count});
+    }
+    // tensor(): 3 x size() view, row 0 = x, row 1 = y, row 2 = z
+    auto tensor()
+    {
+        return xt::adapt(buffer, 3 * (size_t)count, xt::no_ownership(),
+                         std::array<size_t, 2>{3, (size_t)count},
+                         std::array<std::ptrdiff_t, 2>{stride, 1});
+    }
+    // adapt(list): size() x 3 view of the points of "list", one row per point; valid until the list reallocates
+    static auto adapt(XArrayList<Point> &list)
+    {
+        static_assert(sizeof(Point) == 3 * sizeof(float) && std::is_standard_layout<Point>::value,
+                      "Point must be three packed floats");
+        size_t n = list.size();
+        return xt::adapt(reinterpret_cast<float *>(list.rawData()), 3 * n, xt::no_ownership(),
+                         std::array<size_t, 2>{n, 3},
+                         std::array<std::ptrdiff_t, 2>{3, 1});
+    }
+
+protected:
+    static float *allocate(int stride);
+    static void deallocate(float *buffer);
+    void reallocate(int newStride);
+    void checkIndex(int index) const
+    {
+        if (index < 0 || index >= count)
+            throw out_of_range("Index is out of range!");
+    }
+    // epsilon(): largest float below EPSILON, so that |d| <= epsilon() in float <=> |d| < EPSILON in double
+    static float epsilon()
+    {
+        float eps = (float)EPSILON;
+        return (double)eps < EPSILON ? eps : nextafterf(eps, 0.0f);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+inline PointCloud::PointCloud(int capacity)
+{
+    stride = (capacity + LANES - 1) / LANES * LANES;
+    buffer = allocate(stride);
+    count = 0;
+}
+
+inline PointCloud::PointCloud(const Point *points, int n) : PointCloud(n)
+{
+    float *x = xData(), *y = yData(), *z = zData();
+    for (int i = 0; i < n; i++)
+    {
+        x[i] = points[i].getX();
+        y[i] = points[i].getY();
+        z[i] = points[i].getZ();
+    }
+    count = n;
+}
+
+inline PointCloud::PointCloud(XArrayList<Point> &list) : PointCloud(list.rawData(), list.size())
+{
+}
+
+inline PointCloud::PointCloud(const PointCloud &cloud) : PointCloud(cloud.count)
+{
+    if (cloud.count > 0)
+    {
+        memcpy(xData(), cloud.xData(), cloud.count * sizeof(float));
+        memcpy(yData(), cloud.yData(), cloud.count * sizeof(float));
+        memcpy(zData(), cloud.zData(), cloud.count * sizeof(float));
+    }
+    count = cloud.count;
+}
+
+inline PointCloud::PointCloud(PointCloud &&cloud) noexcept
+{
+    buffer = cloud.buffer;
+    stride = cloud.stride;
+    count = cloud.count;
+    cloud.buffer = nullptr;
+    cloud.stride = 0;
+    cloud.count = 0;
+}
+
+inline PointCloud &PointCloud::operator=(const PointCloud &cloud)
+{
+    if (this != &cloud)
+    {
+        PointCloud copy(cloud);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+inline PointCloud &PointCloud::operator=(PointCloud &&cloud) noexcept
+{
+    if (this != &cloud)
+    {
+        deallocate(buffer);
+        buffer = cloud.buffer;
+        stride = cloud.stride;
+        count = cloud.count;
+        cloud.buffer = nullptr;
+        cloud.stride = 0;
+        cloud.count = 0;
+    }
+    return *this;
+}
+
+inline PointCloud::~PointCloud()
+{
+    deallocate(buffer);
+}
+
+inline void PointCloud::add(float x, float y, float z)
+{
+    if (count == stride)
+    {
+        reallocate(stride > 0 ? 2 * stride : LANES);
+    }
+    xData()[count] = x;
+    yData()[count] = y;
+    zData()[count] = z;
+    count++;
+}
+
+inline Point PointCloud::get(int index) const
+{
+    checkIndex(index);
+    return Point(xData()[index], yData()[index], zData()[index]);
+}
+
+inline void PointCloud::set(int index, const Point &point)
+{
+    checkIndex(index);
+    xData()[index] = point.getX();
+    yData()[index] = point.getY();
+    zData()[index] = point.getZ();
+}
+
+inline void PointCloud::reserve(int n)
+{
+    if (n > stride)
+    {
+        reallocate((n + LANES - 1) / LANES * LANES);
+    }
+}
+
+inline void PointCloud::toList(XArrayList<Point> &list) const
+{
+    list.reserve(list.size() + count);
+    for (int i = 0; i < count; i++)
+    {
+        list.add(Point(xData()[i], yData()[i], zData()[i]));
+    }
+}
+
+inline PointCloud PointCloud::genPoints(int size, float minValue, float maxValue,
+                                        bool manualSeed, int seedValue)
+{
+    PointCloud cloud(size);
+    std::default_random_engine engine(manualSeed ? static_cast<long unsigned int>(seedValue)
+                                                 : static_cast<long unsigned int>(time(0)));
+    uniform_real_distribution<double> dist(minValue, maxValue);
+    float *x = cloud.xData(), *y = cloud.yData(), *z = cloud.zData();
+    for (int idx = 0; idx < size; idx++)
+    {
+        x[idx] = dist(engine);
+        y[idx] = dist(engine);
+        z[idx] = dist(engine);
+    }
+    cloud.count = size;
+    return cloud;
+}
+
+inline PointCloud PointCloud::genPointsParallel(int size, float minValue, float maxValue,
+                                                unsigned long long seedValue, int threads)
+{
+    PointCloud cloud(size);
+    float *x = cloud.xData(), *y = cloud.yData(), *z = cloud.zData();
+    Point::parallelChunks(size, threads, [=](long long first, long long last)
+                          {
+                              const long long BATCH = 1024;
+                              float values[3 * BATCH];
+                              for (long long idx = first; idx < last; idx += BATCH)
+                              {
+                                  long long n = last - idx < BATCH ? last - idx : BATCH;
+                                  philoxUniform(values, 3 * idx, 3 * n, seedValue, minValue, maxValue);
+                                  for (long long k = 0; k < n; k++)
+                                  {
+                                      x[idx + k] = values[3 * k];
+                                      y[idx + k] = values[3 * k + 1];
+                                      z[idx + k] = values[3 * k + 2];
+                                  }
+                              } });
+    cloud.count = size;
+    return cloud;
+}
+
+inline void PointCloud::radius(float *out) const
+{
+    const float *x = xData(), *y = yData(), *z = zData();
+    int i = 0;
+#if defined(__AVX__)
+    for (; i + LANES <= count; i += LANES)
+    {
+        __m256 vx = _mm256_load_ps(x + i);
+        __m256 vy = _mm256_load_ps(y + i);
+        __m256 vz = _mm256_load_ps(z + i);
+        __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+        _mm256_storeu_ps(out + i, _mm256_sqrt_ps(sum));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float sum = x[i] * x[i] + y[i] * y[i];
+        sum = sum + z[i] * z[i];
+        out[i] = sqrt(sum);
+    }
+}
+
+inline int PointCloud::pointEQ(const Point &point, bool *out) const
+{
+    const float *x = xData(), *y = yData(), *z = zData();
+    float px = point.getX(), py = point.getY(), pz = point.getZ();
+    float eps = epsilon();
+    int matches = 0;
+    int i = 0;
+#if defined(__AVX__)
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 vpx = _mm256_set1_ps(px), vpy = _mm256_set1_ps(py), vpz = _mm256_set1_ps(pz);
+    __m256 veps = _mm256_set1_ps(eps);
+    for (; i + LANES <= count; i += LANES)
+    {
+        __m256 dx = _mm256_and_ps(_mm256_sub_ps(vpx, _mm256_load_ps(x + i)), absMask);
+        __m256 dy = _mm256_and_ps(_mm256_sub_ps(vpy, _mm256_load_ps(y + i)), absMask);
+        __m256 dz = _mm256_and_ps(_mm256_sub_ps(vpz, _mm256_load_ps(z + i)), absMask);
+        __m256 eq = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(dx, veps, _CMP_LE_OQ), _mm256_cmp_ps(dy, veps, _CMP_LE_OQ)),
+                                  _mm256_cmp_ps(dz, veps, _CMP_LE_OQ));
+        int mask = _mm256_movemask_ps(eq);
+        for (int lane = 0; lane < LANES; lane++)
+            out[i + lane] = (mask >> lane) & 1;
+        matches += __builtin_popcount(mask);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        out[i] = fabsf(px - x[i]) <= eps && fabsf(py - y[i]) <= eps && fabsf(pz - z[i]) <= eps;
+        matches += out[i];
+    }
+    return matches;
+}
+
+inline int PointCloud::indexOf(const Point &point) const
+{
+    const float *x = xData(), *y = yData(), *z = zData();
+    float px = point.getX(), py = point.getY(), pz = point.getZ();
+    float eps = epsilon();
+    int i = 0;
+#if defined(__AVX__)
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 vpx = _mm256_set1_ps(px), vpy = _mm256_set1_ps(py), vpz = _mm256_set1_ps(pz);
+    __m256 veps = _mm256_set1_ps(eps);
+    for (; i + LANES <= count; i += LANES)
+    {
+        __m256 dx = _mm256_and_ps(_mm256_sub_ps(vpx, _mm256_load_ps(x + i)), absMask);
+        __m256 dy = _mm256_and_ps(_mm256_sub_ps(vpy, _mm256_load_ps(y + i)), absMask);
+        __m256 dz = _mm256_and_ps(_mm256_sub_ps(vpz, _mm256_load_ps(z + i)), absMask);
+        __m256 eq = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(dx, veps, _CMP_LE_OQ), _mm256_cmp_ps(dy, veps, _CMP_LE_OQ)),
+                                  _mm256_cmp_ps(dz, veps, _CMP_LE_OQ));
+        int mask = _mm256_movemask_ps(eq);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        if (fabsf(px - x[i]) <= eps && fabsf(py - y[i]) <= eps && fabsf(pz - z[i]) <= eps)
+            return i;
+    }
+    return -1;
+}
+
+inline Point PointCloud::centroid() const
+{
+    if (count == 0)
+        throw out_of_range("PointCloud is empty!");
+    const float *x = xData(), *y = yData(), *z = zData();
+    double sx = 0, sy = 0, sz = 0;
+    int i = 0;
+#if defined(__AVX__)
+    __m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd(), az = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4)
+    {
+        ax = _mm256_add_pd(ax, _mm256_cvtps_pd(_mm_load_ps(x + i)));
+        ay = _mm256_add_pd(ay, _mm256_cvtps_pd(_mm_load_ps(y + i)));
+        az = _mm256_add_pd(az, _mm256_cvtps_pd(_mm_load_ps(z + i)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, ax);
+    sx = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_pd(lanes, ay);
+    sy = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_pd(lanes, az);
+    sz = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < count; i++)
+    {
+        sx += x[i];
+        sy += y[i];
+        sz += z[i];
+    }
+    return Point(sx / count, sy / count, sz / count);
+}
+
+inline void PointCloud::boundingBox(Point &lower, Point &upper) const
+{
+    if (count == 0)
+        throw out_of_range("PointCloud is empty!");
+    const float *data[3] = {xData(), yData(), zData()};
+    float low[3], high[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const float *values = data[axis];
+        float lo = values[0], hi = values[0];
+        int i = 0;
+#if defined(__AVX__)
+        if (count >= LANES)
+        {
+            __m256 vlo = _mm256_load_ps(values), vhi = vlo;
+            for (i = LANES; i + LANES <= count; i += LANES)
+            {
+                __m256 v = _mm256_load_ps(values + i);
+                vlo = _mm256_min_ps(vlo, v);
+                vhi = _mm256_max_ps(vhi, v);
+            }
+            float lanesLo[LANES], lanesHi[LANES];
+            _mm256_storeu_ps(lanesLo, vlo);
+            _mm256_storeu_ps(lanesHi, vhi);
+            for (int lane = 0; lane < LANES; lane++)
+            {
+                lo = lanesLo[lane] < lo ? lanesLo[lane] : lo;
+                hi = lanesHi[lane] > hi ? lanesHi[lane] : hi;
+            }
+        }
+#endif
+        for (; i < count; i++)
+        {
+            lo = values[i] < lo ? values[i] : lo;
+            hi = values[i] > hi ? values[i] : hi;
+        }
+        low[axis] = lo;
+        high[axis] = hi;
+    }
+    lower = Point(low[0], low[1], low[2]);
+    upper = Point(high[0], high[1], high[2]);
+}
+
+//////////////////////////////////////////////////////////////////////
+//////////////////////// (private) METHOD DEFNITION //////////////////
+//////////////////////////////////////////////////////////////////////
+
+inline float *PointCloud::allocate(int stride)
+{
+    if (stride <= 0)
+        return nullptr;
+    return static_cast<float *>(::operator new(3 * (size_t)stride * sizeof(float), std::align_val_t(ALIGN)));
+}
+
+inline void PointCloud::deallocate(float *buffer)
+{
+    if (buffer != nullptr)
+        ::operator delete(buffer, std::align_val_t(ALIGN));
+}
+
+inline void PointCloud::reallocate(int newStride)
+{
+    float *newBuffer = allocate(newStride);
+    for (int axis = 0; axis < 3 && count > 0; axis++)
+    {
+        memcpy(newBuffer + axis * (size_t)newStride, buffer + axis * (size_t)stride, count * sizeof(float));
+    }
+    deallocate(buffer);
+    buffer = newBuffer;
+    stride = newStride;
+}
+
+#endif /* POINTCLOUD_H */
@@ -0,0 +1,625 @@
+/*
+ * File:   SpatialIndex.h
+ *
+ * Spatial indexes over a fixed set of points, replacing linear scans with
+ * Point::pointEQ:
+ *      PointKDTree     a balanced k-d tree (split on the widest axis, median
+ *                      found with nth_element); good for any distribution
+ *      PointGrid       a uniform grid of cubic cells, found through a hash
+ *                      table; fastest when the points are spread evenly
+ *
+ * Both are built in O(n log n) from a PointCloud, an array of Point or an
+ * XArrayList<Point>, and copy the points (reordered for the index), so the
+ * source can change or go away afterwards. Queries return locations in the
+ * source:
+ *      find(point)             lowest location of a point equal to "point" (Point::operator==)
+ *      nearest(point, k)       the k nearest points, closest first
+ *      within(center, radius)  all points at distance <= radius
+ *      findBatch, nearestBatch one query per point of a PointCloud, spread over threads
+ *      distinct()              locations of the points that remain after dropping duplicates,
+ *                              the same as adding the points one by one to a list unless it
+ *                              already contains an equal one
+ *
+ * Queries do not change the index: any number of threads may query it at once.
+ */
+
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+#include "util/Point.h"
+#include "util/PointCloud.h"
+#include "list/XArrayList.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+class SpatialIndex
+{
+public:
+    virtual ~SpatialIndex() {}
+
+    int size() const
+    {
+        return points.size();
+    }
+    // find(point): lowest location of a point equal to "point", -1 if none
+    int find(const Point &point) const
+    {
+        return firstEqual(point.getX(), point.getY(), point.getZ(), 0);
+    }
+    bool contains(const Point &point) const
+    {
+        return find(point) != -1;
+    }
+    // nearest(point, k): locations of the k nearest points (fewer if the index is smaller), closest first
+    XArrayList<int> nearest(const Point &point, int k) const;
+    // within(center, radius): locations of all points at distance <= radius, in no particular order
+    XArrayList<int> within(const Point &center, float radius) const;
+    // findBatch(queries): find() of every query point; nearestBatch(queries): location of the nearest point to each
+    XArrayList<int> findBatch(const PointCloud &queries) const;
+    XArrayList<int> nearestBatch(const PointCloud &queries) const;
+    // distinct(): locations of the points kept by deduplication, in increasing order
+    XArrayList<int> distinct() const;
+
+protected:
+    typedef vector<pair<double, int>> Heap; // max-heap of (squared distance, slot) for k-nearest searches
+
+    PointCloud points; // the indexed points, in the index's own order ("slots")
+    vector<int> ids;   // ids[slot]: location of that point in the source
+
+    // firstEqual(x, y, z, kept): lowest location of a point equal to (x, y, z); only points
+    //      whose location is marked in "kept" count, unless kept is 0; -1 if none
+    virtual int firstEqual(float x, float y, float z, const char *kept) const = 0;
+    // knn(x, y, z, k, heap): leave the k nearest slots in "heap"
+    virtual void knn(float x, float y, float z, int k, Heap &heap) const = 0;
+    // collectWithin(x, y, z, radius, out): add the locations of all points at distance <= radius
+    virtual void collectWithin(float x, float y, float z, float radius, XArrayList<int> &out) const = 0;
+
+    // equal: the test of Point::operator==, one coordinate
+    static bool equal(float a, float b)
+    {
+        return fabsf(a - b) < EPSILON;
+    }
+    bool equalAt(int slot, float x, float y, float z) const
+    {
+        return equal(points.xData()[slot], x) && equal(points.yData()[slot], y) && equal(points.zData()[slot], z);
+    }
+    double distance2(int slot, float x, float y, float z) const
+    {
+        double dx = (double)points.xData()[slot] - x;
+        double dy = (double)points.yData()[slot] - y;
+        double dz = (double)points.zData()[slot] - z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+    static void offer(Heap &heap, int k, double distance2, int slot)
+    {
+        if ((int)heap.size() < k)
+        {
+            heap.push_back(make_pair(distance2, slot));
+            push_heap(heap.begin(), heap.end());
+        }
+        else if (distance2 < heap.front().first)
+        {
+            pop_heap(heap.begin(), heap.end());
+            heap.back() = make_pair(distance2, slot);
+            push_heap(heap.begin(), heap.end());
+        }
+    }
+    // load(cloud, order): copy the points of "cloud" into "points", in the given order of locations
+    void load(const PointCloud &cloud, vector<int> &order);
+    // parallelFor(n, fn): fn(i) for i in [0, n), on up to hardware_concurrency threads
+    template <class Fn>
+    static void parallelFor(int n, Fn fn);
+};
+
+/* PointKDTree: an implicit k-d tree over the slots. The range [lo, hi) has its
+ * node at mid = (lo + hi) / 2: slots [lo, mid) lie on the low side of the
+ * split axis, [mid + 1, hi) on the high side. Ranges of at most LEAF slots
+ * are scanned.
+ */
+class PointKDTree : public SpatialIndex
+{
+public:
+    PointKDTree(const PointCloud &cloud);
+    PointKDTree(const Point *points, int n) : PointKDTree(PointCloud(points, n)) {}
+    PointKDTree(XArrayList<Point> &list) : PointKDTree(PointCloud(list)) {}
+
+protected:
+    static const int LEAF = 8;
+    vector<unsigned char> axes; // axes[mid]: split axis of the node at slot "mid"
+
+    const float *coordinates(int axis) const
+    {
+        return axis == 0 ? points.xData() : axis == 1 ? points.yData() : points.zData();
+    }
+    void build(const PointCloud &cloud, vector<int> &order, vector<unsigned char> &splits, int lo, int hi);
+    int firstEqual(float x, float y, float z, const char *kept) const;
+    void knn(float x, float y, float z, int k, Heap &heap) const;
+    void collectWithin(float x, float y, float z, float radius, XArrayList<int> &out) const;
+    void searchEqual(int lo, int hi, const float *query, const char *kept, int &best) const;
+    void searchNearest(int lo, int hi, const float *query, int k, Heap &heap) const;
+    void searchWithin(int lo, int hi, const float *query, float radius, XArrayList<int> &out) const;
+};
+
+/* PointGrid: cubic cells of side cellSize from the lower corner of the points'
+ * bounding box. Slots are sorted by cell, and a hash table maps each
+ * non-empty cell to its range of slots.
+ */
+class PointGrid : public SpatialIndex
+{
+public:
+    // PointGrid(cloud, cellSize): cellSize <= 0 picks one with about two points per cell
+    PointGrid(const PointCloud &cloud, float cellSize = 0);
+    PointGrid(const Point *points, int n, float cellSize = 0) : PointGrid(PointCloud(points, n), cellSize) {}
+    PointGrid(XArrayList<Point> &list, float cellSize = 0) : PointGrid(PointCloud(list), cellSize) {}
+
+    float getCellSize() const
+    {
+        return cellSize;
+    }
+
+protected:
+    static const int CELL_BITS = 21; // bits of a cell coordinate in a cell key
+    static constexpr uint64_t EMPTY = ~(uint64_t)0;
+
+    float origin[3];
+    float cellSize;
+    int64_t dims[3]; // cells along each axis
+    vector<uint64_t> tableKeys; // hash table: cell key, or EMPTY
+    vector<int> tableStart;     // first slot of the cell
+    vector<int> tableEnd;       // one past its last slot
+    uint64_t tableMask;
+
+    int64_t cellOf(float coordinate, int axis) const
+    {
+        return (int64_t)floor(((double)coordinate - origin[axis]) / cellSize);
+    }
+    static uint64_t keyOf(int64_t ix, int64_t iy, int64_t iz)
+    {
+        return ((uint64_t)ix << (2 * CELL_BITS)) | ((uint64_t)iy << CELL_BITS) | (uint64_t)iz;
+    }
+    uint64_t hashOf(uint64_t key) const
+    {
+        return (key * 0x9E3779B97F4A7C15ull >> 20) & tableMask;
+    }
+    // cellRange(ix, iy, iz, start, end): slots [start, end) of a cell; false if it is empty or outside the grid
+    bool cellRange(int64_t ix, int64_t iy, int64_t iz, int &start, int &end) const;
+    int firstEqual(float x, float y, float z, const char *kept) const;
+    void knn(float x, float y, float z, int k, Heap &heap) const;
+    void collectWithin(float x, float y, float z, float radius, XArrayList<int> &out) const;
+};
+
+//////////////////////////////////////////////////////////////////////
+////////////////////////     METHOD DEFNITION      ///////////////////
+//////////////////////////////////////////////////////////////////////
+
+inline XArrayList<int> SpatialIndex::nearest(const Point &point, int k) const
+{
+    Heap heap;
+    if (k > 0)
+        knn(point.getX(), point.getY(), point.getZ(), k, heap);
+    sort_heap(heap.begin(), heap.end());
+    XArrayList<int> result(0, 0, (int)heap.size());
+    for (auto &entry : heap)
+        result.add(ids[entry.second]);
+    return result;
+}
+
+inline XArrayList<int> SpatialIndex::within(const Point &center, float radius) const
+{
+    XArrayList<int> result;
+    if (radius >= 0)
+        collectWithin(center.getX(), center.getY(), center.getZ(), radius, result);
+    return result;
+}
+
+inline XArrayList<int> SpatialIndex::findBatch(const PointCloud &queries) const
+{
+    int n = queries.size();
+    vector<int> found(n);
+    parallelFor(n, [&](int i)
+                { found[i] = firstEqual(queries.xData()[i], queries.yData()[i], queries.zData()[i], 0); });
+    XArrayList<int> result;
+    result.addAll(found.data(), n);
+    return result;
+}
+
+inline XArrayList<int> SpatialIndex::nearestBatch(const PointCloud &queries) const
+{
+    int n = queries.size();
+    vector<int> found(n);
+    parallelFor(n, [&](int i)
+                {
+                    Heap heap;
+                    knn(queries.xData()[i], queries.yData()[i], queries.zData()[i], 1, heap);
+                    found[i] = heap.empty() ? -1 : ids[heap.front().second]; });
+    XArrayList<int> result;
+    result.addAll(found.data(), n);
+    return result;
+}
+
+inline XArrayList<int> SpatialIndex::distinct() const
+{
+    // in source order: keep a point unless an equal point was kept before it
+    int n = size();
+    vector<int> slots(n);
+    for (int slot = 0; slot < n; slot++)
+        slots[ids[slot]] = slot;
+    vector<char> kept(n, 0);
+    XArrayList<int> result;
+    for (int id = 0; id < n; id++)
+    {
+        int slot = slots[id];
+        if (firstEqual(points.xData()[slot], points.yData()[slot], points.zData()[slot], kept.data()) == -1)
+        {
+            kept[id] = 1;
+            result.add(id);
+        }
+    }
+    return result;
+}
+
+inline void SpatialIndex::load(const PointCloud &cloud, vector<int> &order)
+{
+    int n = (int)order.size();
+    points = PointCloud(n);
+    for (int slot = 0; slot < n; slot++)
+    {
+        int id = order[slot];
+        points.add(cloud.xData()[id], cloud.yData()[id], cloud.zData()[id]);
+    }
+    ids.swap(order);
+}
+
+template <class Fn>
+void SpatialIndex::parallelFor(int n, Fn fn)
+{
+    int threads = (int)std::thread::hardware_concurrency();
+    int maxThreads = n / 1024 + 1; // at least ~1024 queries per thread
+    threads = threads < 1 ? 1 : threads > maxThreads ? maxThreads : threads;
+    if (threads == 1)
+    {
+        for (int i = 0; i < n; i++)
+            fn(i);
+        return;
+    }
+    vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        int first = (int)((long long)n * t / threads), last = (int)((long long)n * (t + 1) / threads);
+        workers.emplace_back([first, last, &fn]
+                             {
+                                 for (int i = first; i < last; i++)
+                                     fn(i); });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+////////////////////////////// PointKDTree ///////////////////////////
+
+inline PointKDTree::PointKDTree(const PointCloud &cloud)
+{
+    int n = cloud.size();
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    axes.assign(n, 0);
+    build(cloud, order, axes, 0, n);
+    load(cloud, order);
+}
+
+inline void PointKDTree::build(const PointCloud &cloud, vector<int> &order, vector<unsigned char> &splits, int lo, int hi)
+{
+    if (hi - lo <= LEAF)
+        return;
+    const float *source[3] = {cloud.xData(), cloud.yData(), cloud.zData()};
+
+    // split on the axis along which the range is widest
+    int axis = 0;
+    float widest = -1;
+    for (int a = 0; a < 3; a++)
+    {
+        float low = source[a][order[lo]], high = low;
+        for (int i = lo + 1; i < hi; i++)
+        {
+            float value = source[a][order[i]];
+            low = value < low ? value : low;
+            high = value > high ? value : high;
+        }
+        if (high - low > widest)
+        {
+            widest = high - low;
+            axis = a;
+        }
+    }
+    int mid = lo + (hi - lo) / 2;
+    const float *values = source[axis];
+    nth_element(order.begin() + lo, order.begin() + mid, order.begin() + hi,
+                [values](int a, int b)
+                { return values[a] < values[b]; });
+    splits[mid] = (unsigned char)axis;
+    build(cloud, order, splits, lo, mid);
+    build(cloud, order, splits, mid + 1, hi);
+}
+
+inline int PointKDTree::firstEqual(float x, float y, float z, const char *kept) const
+{
+    float query[3] = {x, y, z};
+    int best = INT_MAX;
+    searchEqual(0, size(), query, kept, best);
+    return best == INT_MAX ? -1 : best;
+}
+
+inline void PointKDTree::searchEqual(int lo, int hi, const float *query, const char *kept, int &best) const
+{
+    // descend into every side that may hold a coordinate within EPSILON (with margin for rounding)
+    const double margin = 2 * EPSILON;
+    while (hi - lo > LEAF)
+    {
+        int mid = lo + (hi - lo) / 2;
+        int axis = axes[mid];
+        double split = coordinates(axis)[mid];
+        if (equalAt(mid, query[0], query[1], query[2]) && ids[mid] < best && (kept == 0 || kept[ids[mid]]))
+            best = ids[mid];
+        bool low = query[axis] - margin <= split;
+        bool high = query[axis] + margin >= split;
+        if (low && high)
+        {
+            searchEqual(mid + 1, hi, query, kept, best);
+            hi = mid;
+        }
+        else if (low)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    for (int slot = lo; slot < hi; slot++)
+    {
+        if (equalAt(slot, query[0], query[1], query[2]) && ids[slot] < best && (kept == 0 || kept[ids[slot]]))
+            best = ids[slot];
+    }
+}
+
+inline void PointKDTree::knn(float x, float y, float z, int k, Heap &heap) const
+{
+    float query[3] = {x, y, z};
+    searchNearest(0, size(), query, k, heap);
+}
+
+inline void PointKDTree::searchNearest(int lo, int hi, const float *query, int k, Heap &heap) const
+{
+    if (hi - lo <= LEAF)
+    {
+        for (int slot = lo; slot < hi; slot++)
+            offer(heap, k, distance2(slot, query[0], query[1], query[2]), slot);
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    int axis = axes[mid];
+    double gap = (double)query[axis] - coordinates(axis)[mid];
+    offer(heap, k, distance2(mid, query[0], query[1], query[2]), mid);
+    // the query's side first; the other side only if it can still hold a closer point
+    if (gap < 0)
+        searchNearest(lo, mid, query, k, heap);
+    else
+        searchNearest(mid + 1, hi, query, k, heap);
+    if ((int)heap.size() < k || gap * gap < heap.front().first)
+    {
+        if (gap < 0)
+            searchNearest(mid + 1, hi, query, k, heap);
+        else
+            searchNearest(lo, mid, query, k, heap);
+    }
+}
+
+inline void PointKDTree::collectWithin(float x, float y, float z, float radius, XArrayList<int> &out) const
+{
+    float query[3] = {x, y, z};
+    searchWithin(0, size(), query, radius, out);
+}
+
+inline void PointKDTree::searchWithin(int lo, int hi, const float *query, float radius, XArrayList<int> &out) const
+{
+    double limit = (double)radius * radius;
+    while (hi - lo > LEAF)
+    {
+        int mid = lo + (hi - lo) / 2;
+        int axis = axes[mid];
+        double gap = (double)query[axis] - coordinates(axis)[mid];
+        if (distance2(mid, query[0], query[1], query[2]) <= limit)
+            out.add(ids[mid]);
+        bool low = gap <= radius;   // split >= query - radius
+        bool high = -gap <= radius; // split <= query + radius
+        if (low && high)
+        {
+            searchWithin(mid + 1, hi, query, radius, out);
+            hi = mid;
+        }
+        else if (low)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    for (int slot = lo; slot < hi; slot++)
+    {
+        if (distance2(slot, query[0], query[1], query[2]) <= limit)
+            out.add(ids[slot]);
+    }
+}
+
+////////////////////////////// PointGrid /////////////////////////////
+
+inline PointGrid::PointGrid(const PointCloud &cloud, float cellSize)
+{
+    int n = cloud.size();
+    Point lower, upper;
+    if (n > 0)
+        cloud.boundingBox(lower, upper);
+    origin[0] = lower.getX();
+    origin[1] = lower.getY();
+    origin[2] = lower.getZ();
+    double extent[3] = {(double)upper.getX() - lower.getX(), (double)upper.getY() - lower.getY(),
+                        (double)upper.getZ() - lower.getZ()};
+    double largest = max(extent[0], max(extent[1], extent[2]));
+    if (cellSize <= 0)
+    {
+        // about two points per cell over the bounding box (flat axes count as one cell thick)
+        double volume = 1;
+        int axesUsed = 0;
+        for (int a = 0; a < 3; a++)
+        {
+            if (extent[a] > 0)
+            {
+                volume *= extent[a];
+                axesUsed++;
+            }
+        }
+        cellSize = axesUsed == 0 ? 1.0f : (float)pow(volume * 2 / max(n, 1), 1.0 / axesUsed);
+    }
+    // cell coordinates must fit in CELL_BITS bits
+    double minSize = largest / ((1 << CELL_BITS) - 2);
+    if (cellSize < minSize)
+        cellSize = (float)minSize * 1.0001f;
+    if (!(cellSize > 0))
+        cellSize = 1;
+    this->cellSize = cellSize;
+    for (int a = 0; a < 3; a++)
+        dims[a] = (int64_t)floor(extent[a] / cellSize) + 1;
+
+    // sort the locations by cell
+    vector<pair<uint64_t, int>> keyed(n);
+    for (int i = 0; i < n; i++)
+    {
+        keyed[i] = make_pair(keyOf(cellOf(cloud.xData()[i], 0), cellOf(cloud.yData()[i], 1), cellOf(cloud.zData()[i], 2)), i);
+    }
+    sort(keyed.begin(), keyed.end());
+    vector<int> order(n);
+    int cells = 0;
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = keyed[i].second;
+        if (i == 0 || keyed[i].first != keyed[i - 1].first)
+            cells++;
+    }
+
+    // hash table of the non-empty cells, at most half full
+    uint64_t capacity = 16;
+    while (capacity < 2 * (uint64_t)cells)
+        capacity *= 2;
+    tableMask = capacity - 1;
+    tableKeys.assign(capacity, EMPTY);
+    tableStart.assign(capacity, 0);
+    tableEnd.assign(capacity, 0);
+    for (int i = 0; i < n;)
+    {
+        int j = i;
+        while (j < n && keyed[j].first == keyed[i].first)
+            j++;
+        uint64_t h = hashOf(keyed[i].first);
+        while (tableKeys[h] != EMPTY)
+            h = (h + 1) & tableMask;
+        tableKeys[h] = keyed[i].first;
+        tableStart[h] = i;
+        tableEnd[h] = j;
+        i = j;
+    }
+    load(cloud, order);
+}
+
+inline bool PointGrid::cellRange(int64_t ix, int64_t iy, int64_t iz, int &start, int &end) const
+{
+    if (ix < 0 || iy < 0 || iz < 0 || ix >= dims[0] || iy >= dims[1] || iz >= dims[2])
+        return false;
+    uint64_t key = keyOf(ix, iy, iz);
+    for (uint64_t h = hashOf(key); tableKeys[h] != EMPTY; h = (h + 1) & tableMask)
+    {
+        if (tableKeys[h] == key)
+        {
+            start = tableStart[h];
+            end = tableEnd[h];
+            return true;
+        }
+    }
+    return false;
+}
+
+inline int PointGrid::firstEqual(float x, float y, float z, const char *kept) const
+{
+    // the cells touched by the box of half-width EPSILON (with margin for rounding)
+    const float margin = 2 * EPSILON;
+    int best = INT_MAX;
+    int start, end;
+    for (int64_t ix = cellOf(x - margin, 0); ix <= cellOf(x + margin, 0); ix++)
+        for (int64_t iy = cellOf(y - margin, 1); iy <= cellOf(y + margin, 1); iy++)
+            for (int64_t iz = cellOf(z - margin, 2); iz <= cellOf(z + margin, 2); iz++)
+            {
+                if (!cellRange(ix, iy, iz, start, end))
+                    continue;
+                for (int slot = start; slot < end; slot++)
+                {
+                    if (equalAt(slot, x, y, z) && ids[slot] < best && (kept == 0 || kept[ids[slot]]))
+                        best = ids[slot];
+                }
+            }
+    return best == INT_MAX ? -1 : best;
+}
+
+inline void PointGrid::knn(float x, float y, float z, int k, Heap &heap) const
+{
+    if (size() == 0)
+        return;
+    // visit rings of cells around the query's cell; cells of ring r + 1 and beyond are at least r * cellSize away
+    int64_t center[3] = {cellOf(x, 0), cellOf(y, 1), cellOf(z, 2)};
+    int64_t lastRing = 0;
+    for (int a = 0; a < 3; a++)
+        lastRing = max(lastRing, max(center[a], dims[a] - 1 - center[a]));
+    int start, end;
+    for (int64_t ring = 0; ring <= lastRing; ring++)
+    {
+        for (int64_t dx = -ring; dx <= ring; dx++)
+            for (int64_t dy = -ring; dy <= ring; dy++)
+            {
+                bool onFace = dx == -ring || dx == ring || dy == -ring || dy == ring;
+                // inside the faces only the two cells at dz = -ring and dz = ring belong to the ring
+                int64_t step = onFace || ring == 0 ? 1 : 2 * ring;
+                for (int64_t dz = -ring; dz <= ring; dz += step)
+                {
+                    if (!cellRange(center[0] + dx, center[1] + dy, center[2] + dz, start, end))
+                        continue;
+                    for (int slot = start; slot < end; slot++)
+                        offer(heap, k, distance2(slot, x, y, z), slot);
+                }
+            }
+        double reach = (double)ring * cellSize;
+        if ((int)heap.size() == k && heap.front().first <= reach * reach)
+            break;
+    }
+}
+
+inline void PointGrid::collectWithin(float x, float y, float z, float radius, XArrayList<int> &out) const
+{
+    double limit = (double)radius * radius;
+    int64_t low[3] = {max<int64_t>(cellOf(x - radius, 0), 0), max<int64_t>(cellOf(y - radius, 1), 0), max<int64_t>(cellOf(z - radius, 2), 0)};
+    int64_t high[3] = {min<int64_t>(cellOf(x + radius, 0), dims[0] - 1), min<int64_t>(cellOf(y + radius, 1), dims[1] - 1),
+                       min<int64_t>(cellOf(z + radius, 2), dims[2] - 1)};
+    int start, end;
+    for (int64_t ix = low[0]; ix <= high[0]; ix++)
+        for (int64_t iy = low[1]; iy <= high[1]; iy++)
+            for (int64_t iz = low[2]; iz <= high[2]; iz++)
+            {
+                if (!cellRange(ix, iy, iz, start, end))
+                    continue;
+                for (int slot = start; slot < end; slot++)
+                {
+                    if (distance2(slot, x, y, z) <= limit)
+                        out.add(ids[slot]);
+                }
+            }
+}
+
+#endif /* SPATIALINDEX_H */